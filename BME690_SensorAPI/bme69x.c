@@ -84,6 +84,9 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme69x_dev *dev);
 
 #endif
 
+/* This internal API is used to decode and compensate a single raw data field */
+static int8_t parse_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev);
+
 /* This internal API is used to read a single data of the sensor */
 static int8_t read_field_data(uint8_t index, struct bme69x_data *data, struct bme69x_dev *dev);
 
@@ -99,9 +102,27 @@ static int8_t get_mem_page(struct bme69x_dev *dev);
 /* This internal API is used to check the bme69x_dev for null pointers */
 static int8_t null_ptr_check(const struct bme69x_dev *dev);
 
+/* This internal API is used to serve a register read from the shadow register map */
+static uint8_t shadow_load(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, const struct bme69x_dev *dev);
+
+/* This internal API is used to update the shadow register map after a transfer */
+static void shadow_store(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev);
+
+/* This internal API is used to write register address/data pairs with as few transfers as possible */
+static int8_t write_pairs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev);
+
+/* This internal API is used to send the register writes pending in a batch */
+static int8_t batch_flush_writes(struct bme69x_dev *dev);
+
+/* This internal API is used to perform the reads deferred in a batch */
+static int8_t batch_flush_reads(struct bme69x_dev *dev);
+
 /* This internal API is used to set heater configurations */
 static int8_t set_conf(const struct bme69x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme69x_dev *dev);
 
+/* This internal API is used to make sure the heater register image holds the given set-point */
+static int8_t get_heatr_img(uint8_t gas_index, struct bme69x_dev *dev);
+
 /* This internal API is used to limit the max value of a parameter */
 static int8_t boundary_check(uint8_t *value, uint8_t max, struct bme69x_dev *dev);
 
@@ -165,15 +186,52 @@ int8_t bme69x_init(struct bme69x_dev *dev)
     return rslt;
 }
 
+/*
+ * @brief This API brings an initialized sensor back after a bus error.
+ */
+int8_t bme69x_reinit(struct bme69x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t chip_id = 0;
+    uint8_t variant_id = 0;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME69X_OK) && (dev->chip_id != BME69X_CHIP_ID))
+    {
+        rslt = bme69x_init(dev);
+    }
+    else if (rslt == BME69X_OK)
+    {
+        /* Pending batched transfers belong to the lost connection */
+        dev->batch.depth = 0;
+        dev->batch.n_writes = 0;
+        dev->batch.n_reads = 0;
+
+        (void) bme69x_soft_reset(dev);
+
+        rslt = bme69x_get_regs(BME69X_REG_CHIP_ID, &chip_id, 1, dev);
+        if (rslt == BME69X_OK)
+        {
+            rslt = bme69x_get_regs(BME69X_REG_VARIANT_ID, &variant_id, 1, dev);
+        }
+
+        /* The calibration data is only valid for the same sensor */
+        if ((rslt == BME69X_OK) && ((chip_id != dev->chip_id) || (variant_id != dev->variant_id)))
+        {
+            rslt = BME69X_E_DEV_NOT_FOUND;
+        }
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API writes the given data to the register address of the sensor
  */
 int8_t bme69x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev)
 {
     int8_t rslt;
-
-    /* Length of the temporary buffer is 2*(length of register)*/
-    uint8_t tmp_buff[BME69X_LEN_INTERLEAVE_BUFF] = { 0 };
     uint16_t index;
 
     /* Check for null pointer in the device structure*/
@@ -182,31 +240,27 @@ int8_t bme69x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
     {
         if ((len > 0) && (len <= (BME69X_LEN_INTERLEAVE_BUFF / 2)))
         {
-            /* Interleave the 2 arrays */
-            for (index = 0; index < len; index++)
+            if (dev->batch.depth > 0)
             {
-                if (dev->intf == BME69X_SPI_INTF)
+                /* Keep the writes for bme69x_batch_commit, in order */
+                if ((dev->batch.n_writes + len) > BME69X_LEN_BATCH_WRITES)
                 {
-                    /* Set the memory page */
-                    rslt = set_mem_page(reg_addr[index], dev);
-                    tmp_buff[(2 * index)] = reg_addr[index] & BME69X_SPI_WR_MSK;
+                    rslt = batch_flush_writes(dev);
                 }
-                else
+
+                if (rslt == BME69X_OK)
                 {
-                    tmp_buff[(2 * index)] = reg_addr[index];
+                    for (index = 0; index < len; index++)
+                    {
+                        dev->batch.wr_addr[dev->batch.n_writes] = reg_addr[index];
+                        dev->batch.wr_data[dev->batch.n_writes] = reg_data[index];
+                        dev->batch.n_writes++;
+                    }
                 }
-
-                tmp_buff[(2 * index) + 1] = reg_data[index];
             }
-
-            /* Write the interleaved array */
-            if (rslt == BME69X_OK)
+            else
             {
-                dev->intf_rslt = dev->write(tmp_buff[0], &tmp_buff[1], (2 * len) - 1, dev->intf_ptr);
-                if (dev->intf_rslt != 0)
-                {
-                    rslt = BME69X_E_COM_FAIL;
-                }
+                rslt = write_pairs(reg_addr, reg_data, len, dev);
             }
         }
         else
@@ -228,25 +282,108 @@ int8_t bme69x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
 int8_t bme69x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev)
 {
     int8_t rslt;
+    uint8_t read_addr = reg_addr;
 
     /* Check for null pointer in the device structure*/
     rslt = null_ptr_check(dev);
     if ((rslt == BME69X_OK) && reg_data)
     {
-        if (dev->intf == BME69X_SPI_INTF)
+        /* Writes pending in a batch go out first, the read has to see them */
+        rslt = batch_flush_writes(dev);
+
+        /* Only go to the sensor if the shadow register map cannot serve the read */
+        if ((rslt == BME69X_OK) && !shadow_load(reg_addr, reg_data, len, dev))
         {
-            /* Set the memory page */
-            rslt = set_mem_page(reg_addr, dev);
+            if (dev->intf == BME69X_SPI_INTF)
+            {
+                /* Set the memory page */
+                rslt = set_mem_page(reg_addr, dev);
+                if (rslt == BME69X_OK)
+                {
+                    read_addr = reg_addr | BME69X_SPI_RD_MSK;
+                }
+            }
+
+            dev->intf_rslt = dev->read(read_addr, reg_data, len, dev->intf_ptr);
+            if (dev->intf_rslt != 0)
+            {
+                rslt = BME69X_E_COM_FAIL;
+            }
+
             if (rslt == BME69X_OK)
             {
-                reg_addr = reg_addr | BME69X_SPI_RD_MSK;
+                shadow_store(reg_addr, reg_data, len, dev);
+            }
+            else if (dev->shadow)
+            {
+                dev->shadow->valid = 0;
             }
         }
+    }
+    else
+    {
+        rslt = BME69X_E_NULL_PTR;
+    }
 
-        dev->intf_rslt = dev->read(reg_addr, reg_data, len, dev->intf_ptr);
-        if (dev->intf_rslt != 0)
+    return rslt;
+}
+
+/*
+ * @brief This API opens a transfer batch.
+ */
+int8_t bme69x_batch_begin(struct bme69x_dev *dev)
+{
+    int8_t rslt;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if (rslt == BME69X_OK)
+    {
+        dev->batch.depth++;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API queues a register read in the open batch.
+ */
+int8_t bme69x_batch_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev)
+{
+    int8_t rslt;
+    struct bme69x_read_seg *seg;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME69X_OK) && reg_data)
+    {
+        if (dev->batch.depth == 0)
         {
-            rslt = BME69X_E_COM_FAIL;
+            rslt = bme69x_get_regs(reg_addr, reg_data, len, dev);
+        }
+        else
+        {
+            if (dev->batch.n_reads == BME69X_LEN_BATCH_READS)
+            {
+                rslt = batch_flush_reads(dev);
+            }
+
+            if (rslt == BME69X_OK)
+            {
+                seg = (dev->batch.n_reads > 0) ? &dev->batch.reads[dev->batch.n_reads - 1] : NULL;
+                if (seg && ((seg->reg_addr + seg->len) == reg_addr) && ((seg->reg_data + seg->len) == reg_data))
+                {
+                    /* Continues the previous read, one burst covers both */
+                    seg->len += len;
+                }
+                else
+                {
+                    seg = &dev->batch.reads[dev->batch.n_reads++];
+                    seg->reg_addr = reg_addr;
+                    seg->reg_data = reg_data;
+                    seg->len = len;
+                }
+            }
         }
     }
     else
@@ -257,6 +394,27 @@ int8_t bme69x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct
     return rslt;
 }
 
+/*
+ * @brief This API closes a transfer batch.
+ */
+int8_t bme69x_batch_commit(struct bme69x_dev *dev)
+{
+    int8_t rslt;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME69X_OK) && (dev->batch.depth > 0))
+    {
+        dev->batch.depth--;
+        if (dev->batch.depth == 0)
+        {
+            rslt = batch_flush_reads(dev);
+        }
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API soft-resets the sensor.
  */
@@ -282,6 +440,20 @@ int8_t bme69x_soft_reset(struct bme69x_dev *dev)
         {
             rslt = bme69x_set_regs(&reg_addr, &soft_rst_cmd, 1, dev);
 
+            /* The reset has to reach the sensor before the wait */
+            if (rslt == BME69X_OK)
+            {
+                rslt = batch_flush_writes(dev);
+            }
+
+            /* All registers are back at their reset values */
+            if (dev->shadow)
+            {
+                dev->shadow->valid = 0;
+            }
+
+            dev->heatr_img.valid = 0;
+
             if (rslt == BME69X_OK)
             {
                 /* Wait for 5ms */
@@ -440,6 +612,11 @@ int8_t bme69x_set_op_mode(const uint8_t op_mode, struct bme69x_dev *dev)
             {
                 tmp_pow_mode &= ~BME69X_MODE_MSK; /* Set to sleep */
                 rslt = bme69x_set_regs(&reg_addr, &tmp_pow_mode, 1, dev);
+                if (rslt == BME69X_OK)
+                {
+                    rslt = batch_flush_writes(dev);
+                }
+
                 dev->delay_us(BME69X_PERIOD_POLL, dev->intf_ptr);
             }
         }
@@ -526,6 +703,46 @@ uint32_t bme69x_get_meas_dur(const uint8_t op_mode, struct bme69x_conf *conf, st
     return meas_dur;
 }
 
+/*
+ * @brief This API waits for a forced mode measurement to complete.
+ */
+int8_t bme69x_wait_data(uint32_t meas_dur, struct bme69x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t status = 0;
+    uint32_t interval = BME69X_POLL_MIN;
+    uint32_t polled = 0;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME69X_OK) && (meas_dur > BME69X_POLL_MARGIN))
+    {
+        dev->delay_us(meas_dur - BME69X_POLL_MARGIN, dev->intf_ptr);
+    }
+
+    while (rslt == BME69X_OK)
+    {
+        rslt = bme69x_get_regs(BME69X_REG_FIELD0, &status, 1, dev);
+        if ((rslt != BME69X_OK) || (status & BME69X_NEW_DATA_MSK))
+        {
+            break;
+        }
+
+        if (polled >= BME69X_POLL_TIMEOUT)
+        {
+            rslt = BME69X_W_NO_NEW_DATA;
+            break;
+        }
+
+        /* Poll often around the expected end, less often once it is overdue */
+        dev->delay_us(interval, dev->intf_ptr);
+        polled += interval;
+        interval = (interval * 2 > BME69X_POLL_MAX) ? BME69X_POLL_MAX : interval * 2;
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API reads the pressure, temperature and humidity and gas data
  * from the sensor, compensates the data and store it in the bme69x_data
@@ -618,6 +835,30 @@ int8_t bme69x_get_data(uint8_t op_mode, struct bme69x_data *data, uint8_t *n_dat
     return rslt;
 }
 
+/*
+ * @brief This API decodes and compensates a forced mode data field read by the caller.
+ */
+int8_t bme69x_parse_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev)
+{
+    int8_t rslt;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME69X_OK) && (buff != NULL) && (data != NULL))
+    {
+        rslt = parse_field_data(buff, data, dev);
+        if ((rslt == BME69X_OK) && !(data->status & BME69X_NEW_DATA_MSK))
+        {
+            rslt = BME69X_W_NO_NEW_DATA;
+        }
+    }
+    else
+    {
+        rslt = BME69X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API is used to set the gas configuration of the sensor.
  */
@@ -628,18 +869,22 @@ int8_t bme69x_set_heatr_conf(uint8_t op_mode, const struct bme69x_heatr_conf *co
     uint8_t hctrl, run_gas = 0;
     uint8_t ctrl_gas_data[2];
     uint8_t ctrl_gas_addr[2] = { BME69X_REG_CTRL_GAS_0, BME69X_REG_CTRL_GAS_1 };
+    int8_t commit_rslt;
 
     if (conf != NULL)
     {
         rslt = bme69x_set_op_mode(BME69X_SLEEP_MODE, dev);
+
+        /* CTRL_GAS is read first so the heater set-points and CTRL_GAS go out in one batch */
         if (rslt == BME69X_OK)
         {
-            rslt = set_conf(conf, op_mode, &nb_conv, dev);
+            rslt = bme69x_get_regs(BME69X_REG_CTRL_GAS_0, ctrl_gas_data, 2, dev);
         }
 
         if (rslt == BME69X_OK)
         {
-            rslt = bme69x_get_regs(BME69X_REG_CTRL_GAS_0, ctrl_gas_data, 2, dev);
+            (void)bme69x_batch_begin(dev);
+            rslt = set_conf(conf, op_mode, &nb_conv, dev);
             if (rslt == BME69X_OK)
             {
                 if (conf->enable == BME69X_ENABLE)
@@ -660,6 +905,12 @@ int8_t bme69x_set_heatr_conf(uint8_t op_mode, const struct bme69x_heatr_conf *co
 
                 rslt = bme69x_set_regs(ctrl_gas_addr, ctrl_gas_data, 2, dev);
             }
+
+            commit_rslt = bme69x_batch_commit(dev);
+            if (rslt == BME69X_OK)
+            {
+                rslt = commit_rslt;
+            }
         }
     }
     else
@@ -719,7 +970,8 @@ int8_t bme69x_selftest_check(const struct bme69x_dev *dev)
     uint8_t n_fields;
     uint8_t i = 0;
     struct bme69x_data data[BME69X_N_MEAS] = { { 0 } };
-    struct bme69x_dev t_dev;
+    /* Zeroed, so t_dev has no shadow, batch or readv of its own */
+    struct bme69x_dev t_dev = { 0 };
     struct bme69x_conf conf;
     struct bme69x_heatr_conf heatr_conf;
 
@@ -734,6 +986,15 @@ int8_t bme69x_selftest_check(const struct bme69x_dev *dev)
         t_dev.intf = dev->intf;
         t_dev.delay_us = dev->delay_us;
         t_dev.intf_ptr = dev->intf_ptr;
+        t_dev.shadow = NULL;
+        t_dev.heatr_img.valid = 0;
+        t_dev.heatr_img.verify = 0;
+
+        /* The self test resets and reconfigures the sensor behind the back of dev */
+        if (dev->shadow)
+        {
+            dev->shadow->valid = 0;
+        }
 
         rslt = bme69x_init(&t_dev);
     }
@@ -1117,16 +1378,60 @@ static uint8_t calc_gas_wait(uint16_t dur)
     return durval;
 }
 
-/* This internal API is used to read a single data of the sensor */
-static int8_t read_field_data(uint8_t index, struct bme69x_data *data, struct bme69x_dev *dev)
+/* This internal API is used to decode and compensate a single raw data field */
+static int8_t parse_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev)
 {
     int8_t rslt = BME69X_OK;
-    uint8_t buff[BME69X_LEN_FIELD] = { 0 };
     uint8_t gas_range;
     uint32_t adc_temp;
     uint32_t adc_pres;
     volatile uint16_t adc_hum;
     uint16_t adc_gas_res;
+
+    data->status = buff[0] & BME69X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME69X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+
+    /* read the raw data from the sensor */
+    adc_pres = (uint32_t)(((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 8) | ((uint32_t)buff[4]));
+    adc_temp = (uint32_t)(((uint32_t)buff[5] << 16) | ((uint32_t)buff[6] << 8) | ((uint32_t)buff[7]));
+    adc_hum = (uint16_t)(((uint32_t)buff[8] << 8) | (uint32_t)buff[9]);
+    adc_gas_res = ((uint16_t)buff[15] << 2) | ((uint16_t)buff[16] >> 6);
+
+    gas_range = buff[16] & BME69X_GAS_RANGE_MSK;
+
+    data->status |= buff[16] & BME69X_GASM_VALID_MSK;
+    data->status |= buff[16] & BME69X_HEAT_STAB_MSK;
+
+    if (data->status & BME69X_NEW_DATA_MSK)
+    {
+        rslt = get_heatr_img(data->gas_index, dev);
+        if (rslt == BME69X_OK)
+        {
+            data->res_heat = dev->heatr_img.res_heat[data->gas_index];
+            data->idac = dev->heatr_img.idac[data->gas_index];
+            data->gas_wait = dev->heatr_img.gas_wait[data->gas_index];
+
+#ifndef BME69X_USE_FPU
+            data->temperature = calc_temperature(adc_temp, dev, &data->t_lin);
+            data->pressure = calc_pressure(adc_pres, data->t_lin, dev);
+#else
+            data->temperature = calc_temperature(adc_temp, dev);
+            data->pressure = calc_pressure(adc_pres, data->temperature, dev);
+#endif
+            data->humidity = calc_humidity(adc_hum, data->temperature, dev);
+            data->gas_resistance = calc_gas_resistance(adc_gas_res, gas_range);
+        }
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to read a single data of the sensor */
+static int8_t read_field_data(uint8_t index, struct bme69x_data *data, struct bme69x_dev *dev)
+{
+    int8_t rslt = BME69X_OK;
+    uint8_t buff[BME69X_LEN_FIELD] = { 0 };
     uint8_t tries = 5;
 
     while ((tries) && (rslt == BME69X_OK))
@@ -1141,48 +1446,14 @@ static int8_t read_field_data(uint8_t index, struct bme69x_data *data, struct bm
             break;
         }
 
-        data->status = buff[0] & BME69X_NEW_DATA_MSK;
-        data->gas_index = buff[0] & BME69X_GAS_INDEX_MSK;
-        data->meas_index = buff[1];
-
-        /* read the raw data from the sensor */
-        adc_pres = (uint32_t)(((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 8) | ((uint32_t)buff[4]));
-        adc_temp = (uint32_t)(((uint32_t)buff[5] << 16) | ((uint32_t)buff[6] << 8) | ((uint32_t)buff[7]));
-        adc_hum = (uint16_t)(((uint32_t)buff[8] << 8) | (uint32_t)buff[9]);
-        adc_gas_res = ((uint16_t)buff[15] << 2) | ((uint16_t)buff[16] >> 6);
-
-        gas_range = buff[16] & BME69X_GAS_RANGE_MSK;
-
-        data->status |= buff[16] & BME69X_GASM_VALID_MSK;
-        data->status |= buff[16] & BME69X_HEAT_STAB_MSK;
+        if (rslt == BME69X_OK)
+        {
+            rslt = parse_field_data(buff, data, dev);
+        }
 
         if ((data->status & BME69X_NEW_DATA_MSK) && (rslt == BME69X_OK))
         {
-            rslt = bme69x_get_regs(BME69X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
-            if (rslt == BME69X_OK)
-            {
-                rslt = bme69x_get_regs(BME69X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
-            }
-
-            if (rslt == BME69X_OK)
-            {
-                rslt = bme69x_get_regs(BME69X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
-            }
-
-            if (rslt == BME69X_OK)
-            {
-#ifndef BME69X_USE_FPU
-                data->temperature = calc_temperature(adc_temp, dev, &data->t_lin);
-                data->pressure = calc_pressure(adc_pres, data->t_lin, dev);
-#else
-                data->temperature = calc_temperature(adc_temp, dev);
-                data->pressure = calc_pressure(adc_pres, data->temperature, dev);
-#endif
-                data->humidity = calc_humidity(adc_hum, data->temperature, dev);
-                data->gas_resistance = calc_gas_resistance(adc_gas_res, gas_range);
-
-                break;
-            }
+            break;
         }
 
         if (rslt == BME69X_OK)
@@ -1207,7 +1478,6 @@ static int8_t read_all_field_data(struct bme69x_data * const data[], struct bme6
     uint16_t adc_hum;
     uint16_t adc_gas_res;
     uint8_t off;
-    uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
     uint8_t i;
 
     if (!data[0] && !data[1] && !data[2])
@@ -1220,11 +1490,6 @@ static int8_t read_all_field_data(struct bme69x_data * const data[], struct bme6
         rslt = bme69x_get_regs(BME69X_REG_FIELD0, buff, (uint32_t) BME69X_LEN_FIELD * 3, dev);
     }
 
-    if (rslt == BME69X_OK)
-    {
-        rslt = bme69x_get_regs(BME69X_REG_IDAC_HEAT0, set_val, 30, dev);
-    }
-
     for (i = 0; ((i < 3) && (rslt == BME69X_OK)); i++)
     {
         off = (uint8_t)(i * BME69X_LEN_FIELD);
@@ -1232,6 +1497,12 @@ static int8_t read_all_field_data(struct bme69x_data * const data[], struct bme6
         data[i]->gas_index = buff[off] & BME69X_GAS_INDEX_MSK;
         data[i]->meas_index = buff[off + 1];
 
+        rslt = get_heatr_img(data[i]->gas_index, dev);
+        if (rslt != BME69X_OK)
+        {
+            break;
+        }
+
         /* read the raw data from the sensor */
         adc_pres =
             (uint32_t)(((uint32_t) buff[off + 2] << 16) | ((uint32_t) buff[off + 3] << 8) | ((uint32_t) buff[off + 4]));
@@ -1244,9 +1515,9 @@ static int8_t read_all_field_data(struct bme69x_data * const data[], struct bme6
         data[i]->status |= buff[off + 16] & BME69X_GASM_VALID_MSK;
         data[i]->status |= buff[off + 16] & BME69X_HEAT_STAB_MSK;
 
-        data[i]->idac = set_val[data[i]->gas_index];
-        data[i]->res_heat = set_val[10 + data[i]->gas_index];
-        data[i]->gas_wait = set_val[20 + data[i]->gas_index];
+        data[i]->idac = dev->heatr_img.idac[data[i]->gas_index];
+        data[i]->res_heat = dev->heatr_img.res_heat[data[i]->gas_index];
+        data[i]->gas_wait = dev->heatr_img.gas_wait[data[i]->gas_index];
 
 #ifndef BME69X_USE_FPU
 
@@ -1306,6 +1577,12 @@ static int8_t set_mem_page(uint8_t reg_addr, struct bme69x_dev *dev)
                     rslt = BME69X_E_COM_FAIL;
                 }
             }
+
+            /* The page on the sensor is unknown after a failed switch */
+            if (rslt != BME69X_OK)
+            {
+                dev->mem_page = BME69X_MEM_PAGE_UNKNOWN;
+            }
         }
     }
 
@@ -1374,7 +1651,200 @@ static int8_t null_ptr_check(const struct bme69x_dev *dev)
     return rslt;
 }
 
-/* This internal API is used to set heater configurations */
+/* This internal API is used to serve a register read from the shadow register map */
+static uint8_t shadow_load(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, const struct bme69x_dev *dev)
+{
+    uint32_t i;
+    uint8_t offset;
+    uint8_t mask;
+
+    if ((dev->shadow == NULL) || (reg_addr < BME69X_SHADOW_START) ||
+        ((reg_addr + len) > (BME69X_SHADOW_START + BME69X_LEN_SHADOW)) || (len == 0))
+    {
+        return 0;
+    }
+
+    offset = reg_addr - BME69X_SHADOW_START;
+    mask = (uint8_t)(((1u << len) - 1) << offset);
+    if ((dev->shadow->valid & mask) != mask)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        reg_data[i] = dev->shadow->regs[offset + i];
+    }
+
+    return 1;
+}
+
+/* This internal API is used to update the shadow register map after a transfer */
+static void shadow_store(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev)
+{
+    uint32_t i;
+    uint8_t offset;
+
+    if (dev->shadow == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        if (((reg_addr + i) < BME69X_SHADOW_START) || ((reg_addr + i) >= (BME69X_SHADOW_START + BME69X_LEN_SHADOW)))
+        {
+            continue;
+        }
+
+        offset = (uint8_t)(reg_addr + i - BME69X_SHADOW_START);
+        dev->shadow->regs[offset] = reg_data[i];
+
+        /* The sensor leaves forced mode on its own, the mode has to be read back */
+        if (((reg_addr + i) == BME69X_REG_CTRL_MEAS) && ((reg_data[i] & BME69X_MODE_MSK) == BME69X_FORCED_MODE))
+        {
+            dev->shadow->valid &= (uint8_t)~(1u << offset);
+        }
+        else
+        {
+            dev->shadow->valid |= (uint8_t)(1u << offset);
+        }
+    }
+}
+
+/* This internal API is used to write register address/data pairs, or to add them to the open batch */
+static int8_t write_pairs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev)
+{
+    int8_t rslt = BME69X_OK;
+    uint8_t tmp_buff[BME69X_LEN_INTERLEAVE_BUFF] = { 0 };
+    uint32_t start = 0;
+    uint32_t index;
+
+    /* Interleave the 2 arrays, with SPI one transfer per run of registers on the same memory page */
+    while ((start < len) && (rslt == BME69X_OK))
+    {
+        if (dev->intf == BME69X_SPI_INTF)
+        {
+            rslt = set_mem_page(reg_addr[start], dev);
+            for (index = start; (index < len) && ((reg_addr[index] > 0x7f) == (reg_addr[start] > 0x7f)); index++)
+            {
+                tmp_buff[2 * (index - start)] = reg_addr[index] & BME69X_SPI_WR_MSK;
+                tmp_buff[(2 * (index - start)) + 1] = reg_data[index];
+            }
+        }
+        else
+        {
+            for (index = start; index < len; index++)
+            {
+                tmp_buff[2 * (index - start)] = reg_addr[index];
+                tmp_buff[(2 * (index - start)) + 1] = reg_data[index];
+            }
+        }
+
+        /* Write the interleaved array */
+        if (rslt == BME69X_OK)
+        {
+            dev->intf_rslt = dev->write(tmp_buff[0], &tmp_buff[1], (2 * (index - start)) - 1, dev->intf_ptr);
+            if (dev->intf_rslt != 0)
+            {
+                rslt = BME69X_E_COM_FAIL;
+            }
+        }
+
+        start = index;
+    }
+
+    if (rslt == BME69X_OK)
+    {
+        for (index = 0; index < len; index++)
+        {
+            shadow_store(reg_addr[index], &reg_data[index], 1, dev);
+        }
+    }
+    else if (dev->shadow)
+    {
+        dev->shadow->valid = 0;
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to send the register writes pending in a batch */
+static int8_t batch_flush_writes(struct bme69x_dev *dev)
+{
+    int8_t rslt = BME69X_OK;
+    uint8_t n_writes = dev->batch.n_writes;
+
+    if (n_writes > 0)
+    {
+        dev->batch.n_writes = 0;
+        rslt = write_pairs(dev->batch.wr_addr, dev->batch.wr_data, n_writes, dev);
+
+        /* set_conf recorded the set-points when they were queued */
+        if (rslt != BME69X_OK)
+        {
+            dev->heatr_img.valid = 0;
+        }
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to perform the reads deferred in a batch */
+static int8_t batch_flush_reads(struct bme69x_dev *dev)
+{
+    int8_t rslt;
+    struct bme69x_read_seg segs[BME69X_LEN_BATCH_READS];
+    const struct bme69x_read_seg *seg;
+    uint8_t n_segs = 0;
+    uint8_t i;
+
+    rslt = batch_flush_writes(dev);
+
+    /* Blocks the shadow register map holds need no transfer */
+    for (i = 0; i < dev->batch.n_reads; i++)
+    {
+        seg = &dev->batch.reads[i];
+        if ((rslt != BME69X_OK) || !shadow_load(seg->reg_addr, seg->reg_data, seg->len, dev))
+        {
+            segs[n_segs++] = *seg;
+        }
+    }
+
+    dev->batch.n_reads = 0;
+    if ((rslt == BME69X_OK) && (n_segs > 0))
+    {
+        if (dev->readv && (dev->intf == BME69X_I2C_INTF))
+        {
+            dev->intf_rslt = dev->readv(segs, n_segs, dev->intf_ptr);
+            if (dev->intf_rslt != 0)
+            {
+                rslt = BME69X_E_COM_FAIL;
+                if (dev->shadow)
+                {
+                    dev->shadow->valid = 0;
+                }
+            }
+            else
+            {
+                for (i = 0; i < n_segs; i++)
+                {
+                    shadow_store(segs[i].reg_addr, segs[i].reg_data, segs[i].len, dev);
+                }
+            }
+        }
+        else
+        {
+            for (i = 0; (i < n_segs) && (rslt == BME69X_OK); i++)
+            {
+                rslt = bme69x_get_regs(segs[i].reg_addr, segs[i].reg_data, segs[i].len, dev);
+            }
+        }
+    }
+
+    return rslt;
+}
+
 static int8_t set_conf(const struct bme69x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme69x_dev *dev)
 {
     int8_t rslt = BME69X_OK;
@@ -1386,6 +1856,10 @@ static int8_t set_conf(const struct bme69x_heatr_conf *conf, uint8_t op_mode, ui
     uint8_t rh_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
     uint8_t gw_reg_addr[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
     uint8_t gw_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    int8_t commit_rslt;
+
+    /* SHD_HEATR_DUR, RES_HEAT and GAS_WAIT go out in one transfer */
+    (void)bme69x_batch_begin(dev);
 
     switch (op_mode)
     {
@@ -1458,6 +1932,64 @@ static int8_t set_conf(const struct bme69x_heatr_conf *conf, uint8_t op_mode, ui
         rslt = bme69x_set_regs(gw_reg_addr, gw_reg_data, write_len, dev);
     }
 
+    commit_rslt = bme69x_batch_commit(dev);
+    if (rslt == BME69X_OK)
+    {
+        rslt = commit_rslt;
+    }
+
+    /* Keep what was written, the set-points stay unknown until IDAC_HEAT has been read once */
+    for (i = 0; i < write_len; i++)
+    {
+        if (rslt == BME69X_OK)
+        {
+            dev->heatr_img.res_heat[i] = rh_reg_data[i];
+            dev->heatr_img.gas_wait[i] = gw_reg_data[i];
+        }
+        else
+        {
+            dev->heatr_img.valid &= (uint16_t)~(1u << i);
+        }
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to make sure the heater register image holds the given set-point */
+static int8_t get_heatr_img(uint8_t gas_index, struct bme69x_dev *dev)
+{
+    int8_t rslt = BME69X_OK;
+    uint8_t set_val[BME69X_LEN_HEATR_SET * 3] = { 0 }; /* idac, res_heat, gas_wait */
+    uint8_t i;
+
+    if (gas_index >= BME69X_LEN_HEATR_SET)
+    {
+        rslt = BME69X_E_INVALID_LENGTH;
+    }
+    else if (!(dev->heatr_img.valid & (1u << gas_index)) || dev->heatr_img.verify)
+    {
+        rslt = bme69x_get_regs(BME69X_REG_IDAC_HEAT0, set_val, BME69X_LEN_HEATR_SET * 3, dev);
+        if (rslt == BME69X_OK)
+        {
+            for (i = 0; i < BME69X_LEN_HEATR_SET; i++)
+            {
+                if ((dev->heatr_img.valid & (1u << i)) &&
+                    ((dev->heatr_img.idac[i] != set_val[i]) ||
+                     (dev->heatr_img.res_heat[i] != set_val[BME69X_LEN_HEATR_SET + i]) ||
+                     (dev->heatr_img.gas_wait[i] != set_val[(2 * BME69X_LEN_HEATR_SET) + i])))
+                {
+                    dev->heatr_img.mismatch++;
+                }
+
+                dev->heatr_img.idac[i] = set_val[i];
+                dev->heatr_img.res_heat[i] = set_val[BME69X_LEN_HEATR_SET + i];
+                dev->heatr_img.gas_wait[i] = set_val[(2 * BME69X_LEN_HEATR_SET) + i];
+            }
+
+            dev->heatr_img.valid = (uint16_t)((1u << BME69X_LEN_HEATR_SET) - 1);
+        }
+    }
+
     return rslt;
 }
 
@@ -1674,19 +2206,31 @@ static int8_t get_calib_data(struct bme69x_dev *dev)
 {
     int8_t rslt;
     uint8_t coeff_array[BME69X_LEN_COEFF_ALL];
+    int8_t commit_rslt;
 
-    rslt = bme69x_get_regs(BME69X_REG_COEFF1, coeff_array, BME69X_LEN_COEFF1, dev);
+    /* The three coefficient blocks are read in one transaction where the interface allows */
+    rslt = bme69x_batch_begin(dev);
     if (rslt == BME69X_OK)
     {
-        rslt = bme69x_get_regs(BME69X_REG_COEFF2, &coeff_array[BME69X_LEN_COEFF1], BME69X_LEN_COEFF2, dev);
-    }
+        rslt = bme69x_batch_read(BME69X_REG_COEFF1, coeff_array, BME69X_LEN_COEFF1, dev);
+        if (rslt == BME69X_OK)
+        {
+            rslt = bme69x_batch_read(BME69X_REG_COEFF2, &coeff_array[BME69X_LEN_COEFF1], BME69X_LEN_COEFF2, dev);
+        }
 
-    if (rslt == BME69X_OK)
-    {
-        rslt = bme69x_get_regs(BME69X_REG_COEFF3,
-                               &coeff_array[BME69X_LEN_COEFF1 + BME69X_LEN_COEFF2],
-                               BME69X_LEN_COEFF3,
-                               dev);
+        if (rslt == BME69X_OK)
+        {
+            rslt = bme69x_batch_read(BME69X_REG_COEFF3,
+                                     &coeff_array[BME69X_LEN_COEFF1 + BME69X_LEN_COEFF2],
+                                     BME69X_LEN_COEFF3,
+                                     dev);
+        }
+
+        commit_rslt = bme69x_batch_commit(dev);
+        if (rslt == BME69X_OK)
+        {
+            rslt = commit_rslt;
+        }
     }
 
     if (rslt == BME69X_OK)
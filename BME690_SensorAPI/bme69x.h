@@ -70,6 +70,25 @@ extern "C" {
  */
 int8_t bme69x_init(struct bme69x_dev *dev);
 
+/*!
+ * \ingroup bme69xApiInit
+ * \page bme69x_api_bme69x_reinit bme69x_reinit
+ * \code
+ * int8_t bme69x_reinit(struct bme69x_dev *dev);
+ * \endcode
+ * @details This API brings an initialized sensor back after a bus error.
+ * It soft-resets the sensor and checks that chip-id and variant-id still
+ * match, the calibration data in the device structure is kept.
+ * Falls back to bme69x_init if the device structure was never initialized.
+ *
+ * @param[in,out] dev : Structure instance of bme69x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_reinit(struct bme69x_dev *dev);
+
 /**
  * \ingroup bme69x
  * \defgroup bme69xApiRegister Registers
@@ -115,6 +134,66 @@ int8_t bme69x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
  */
 int8_t bme69x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev);
 
+/*!
+ * \ingroup bme69xApiRegister
+ * \page bme69x_api_bme69x_batch_begin bme69x_batch_begin
+ * \code
+ * int8_t bme69x_batch_begin(struct bme69x_dev *dev);
+ * \endcode
+ * @details This API opens a transfer batch. Until the matching
+ * bme69x_batch_commit, register writes are collected and sent together,
+ * and reads queued with bme69x_batch_read are deferred. Immediate reads
+ * and driver delays send the pending writes first, so the register
+ * access order is kept. Batches nest, only the outermost commit sends.
+ *
+ * @param[in,out] dev : Structure instance of bme69x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_batch_begin(struct bme69x_dev *dev);
+
+/*!
+ * \ingroup bme69xApiRegister
+ * \page bme69x_api_bme69x_batch_read bme69x_batch_read
+ * \code
+ * int8_t bme69x_batch_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev);
+ * \endcode
+ * @details This API queues a register read in the open batch, reg_data is
+ * only valid after bme69x_batch_commit. Reads of adjacent registers into
+ * adjacent buffers are merged, all others go out in one transaction when
+ * the interface provides a vectored read. Outside a batch it behaves like
+ * bme69x_get_regs.
+ *
+ * @param[in] reg_addr  : Register address from where the data to be read
+ * @param[out] reg_data : Pointer to data buffer to store the read data.
+ * @param[in] len       : No of bytes of data to be read.
+ * @param[in,out] dev   : Structure instance of bme69x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_batch_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme69x_dev *dev);
+
+/*!
+ * \ingroup bme69xApiRegister
+ * \page bme69x_api_bme69x_batch_commit bme69x_batch_commit
+ * \code
+ * int8_t bme69x_batch_commit(struct bme69x_dev *dev);
+ * \endcode
+ * @details This API closes a transfer batch. The outermost commit sends
+ * the pending writes and then performs the deferred reads.
+ *
+ * @param[in,out] dev : Structure instance of bme69x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_batch_commit(struct bme69x_dev *dev);
+
 /**
  * \ingroup bme69x
  * \defgroup bme69xApiSystem System
@@ -219,6 +298,51 @@ uint32_t bme69x_get_meas_dur(const uint8_t op_mode, struct bme69x_conf *conf, st
  */
 int8_t bme69x_get_data(uint8_t op_mode, struct bme69x_data *data, uint8_t *n_data, struct bme69x_dev *dev);
 
+/*!
+ * \ingroup bme69xApiData
+ * \page bme69x_api_bme69x_wait_data bme69x_wait_data
+ * \code
+ * int8_t bme69x_wait_data(uint32_t meas_dur, struct bme69x_dev *dev);
+ * \endcode
+ * @details This API waits for a forced mode measurement to complete. It sleeps
+ * until BME69X_POLL_MARGIN before the expected end and then polls the new
+ * data flag of field 0, starting at BME69X_POLL_MIN and doubling the interval
+ * up to BME69X_POLL_MAX, for at most BME69X_POLL_TIMEOUT. Only the status
+ * byte is read while polling.
+ *
+ * @param[in] meas_dur : Expected time until the measurement completes in
+ *                       microseconds, see bme69x_get_meas_dur plus heater
+ *                       duration.
+ * @param[in,out] dev  : Structure instance of bme69x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning, BME69X_W_NO_NEW_DATA if the data did not arrive
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_wait_data(uint32_t meas_dur, struct bme69x_dev *dev);
+
+/*!
+ * \ingroup bme69xApiData
+ * \page bme69x_api_bme69x_parse_field_data bme69x_parse_field_data
+ * \code
+ * int8_t bme69x_parse_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev);
+ * \endcode
+ * @details This API decodes and compensates a forced mode data field that the
+ * caller has already read from BME69X_REG_FIELD0 (BME69X_LEN_FIELD bytes),
+ * e.g. as part of a transfer that covers several sensors at once.
+ *
+ * @param[in]  buff    : Raw field data, BME69X_LEN_FIELD bytes.
+ * @param[out] data    : Structure instance to hold the data.
+ * @param[in,out] dev  : Structure instance of bme69x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning, BME69X_W_NO_NEW_DATA if the field holds no new data
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_parse_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev);
+
 /**
  * \ingroup bme69x
  * \defgroup bme69xApiConfig Configuration
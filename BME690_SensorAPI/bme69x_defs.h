@@ -97,6 +97,25 @@
 #define BME69X_PERIOD_POLL                        UINT32_C(10000)
 #endif
 
+/* Status polling of bme69x_wait_data (values can be given by user): start
+ * polling this long before the expected end of the measurement, first and
+ * longest interval between two polls, and how long to poll at most */
+#ifndef BME69X_POLL_MARGIN
+#define BME69X_POLL_MARGIN                        UINT32_C(1000)
+#endif
+
+#ifndef BME69X_POLL_MIN
+#define BME69X_POLL_MIN                           UINT32_C(250)
+#endif
+
+#ifndef BME69X_POLL_MAX
+#define BME69X_POLL_MAX                           UINT32_C(8000)
+#endif
+
+#ifndef BME69X_POLL_TIMEOUT
+#define BME69X_POLL_TIMEOUT                       UINT32_C(50000)
+#endif
+
 /* BME69X unique chip identifier */
 #define BME69X_CHIP_ID                            UINT8_C(0x61)
 
@@ -316,6 +335,9 @@
 /* SPI memory page 1 */
 #define BME69X_MEM_PAGE1                          UINT8_C(0x00)
 
+/* SPI memory page not known, forces the next access to select the page */
+#define BME69X_MEM_PAGE_UNKNOWN                   UINT8_C(0xff)
+
 /* Coefficient index macros */
 
 /* Length for all coefficients */
@@ -339,8 +361,23 @@
 /* Length of the configuration register */
 #define BME69X_LEN_CONFIG                         UINT8_C(5)
 
-/* Length of the interleaved buffer */
-#define BME69X_LEN_INTERLEAVE_BUFF                UINT8_C(20)
+/* Maximum number of register writes held by a batch, see bme69x_batch_begin */
+#define BME69X_LEN_BATCH_WRITES                   UINT8_C(32)
+
+/* Maximum number of deferred reads held by a batch */
+#define BME69X_LEN_BATCH_READS                    UINT8_C(8)
+
+/* Length of the interleaved buffer, address and data byte per register */
+#define BME69X_LEN_INTERLEAVE_BUFF                UINT8_C(64)
+
+/* First register held in the shadow register map */
+#define BME69X_SHADOW_START                       BME69X_REG_SHD_HEATR_DUR
+
+/* Length of the shadow register map (0x6E to 0x75) */
+#define BME69X_LEN_SHADOW                         UINT8_C(8)
+
+/* Number of heater set-points (IDAC_HEAT, RES_HEAT and GAS_WAIT registers each) */
+#define BME69X_LEN_HEATR_SET                      UINT8_C(10)
 
 /* Coefficient index macros */
 
@@ -688,6 +725,35 @@ typedef BME69X_INTF_RET_TYPE (*bme69x_read_fptr_t)(uint8_t reg_addr, uint8_t *re
 typedef BME69X_INTF_RET_TYPE (*bme69x_write_fptr_t)(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length,
                                                     void *intf_ptr);
 
+/*!
+ * @brief One register block of a vectored read
+ */
+struct bme69x_read_seg
+{
+    /*! Register address as passed to the read function */
+    uint8_t reg_addr;
+
+    /*! Buffer for the data */
+    uint8_t *reg_data;
+
+    /*! Number of bytes */
+    uint32_t len;
+};
+
+/*!
+ * @brief Optional bus communication function pointer reading several
+ * register blocks in one bus transaction (e.g. one I2C_RDWR message
+ * list). Only used with BME69X_I2C_INTF.
+ *
+ * @param[in]     segs     : Register blocks to read
+ * @param[in]     n_segs   : Number of blocks
+ * @param[in,out] intf_ptr : Void pointer that can enable the linking of descriptors
+ *                           for interface related callbacks
+ * @retval 0 for Success
+ * @retval Non-zero for Failure
+ */
+typedef BME69X_INTF_RET_TYPE (*bme69x_readv_fptr_t)(const struct bme69x_read_seg *segs, uint8_t n_segs, void *intf_ptr);
+
 /*!
  * @brief Delay function pointer which should be mapped to
  * delay function of the user
@@ -921,6 +987,71 @@ struct bme69x_heatr_conf
     uint16_t shared_heatr_dur;
 };
 
+/*
+ * @brief BME69X shadow register map
+ *
+ * Copy of the control registers (BME69X_SHADOW_START, BME69X_LEN_SHADOW
+ * bytes) as last written or read. Reads of valid bytes are served from
+ * memory. Only usable as long as the host is the only writer.
+ */
+struct bme69x_shadow
+{
+    /*! Register values */
+    uint8_t regs[BME69X_LEN_SHADOW];
+
+    /*! Bit n set if regs[n] holds the current register value */
+    uint8_t valid;
+};
+
+/*
+ * @brief BME69X heater register image
+ *
+ * Heater set-points as written by bme69x_set_heatr_conf, so that data reads
+ * do not have to read them back. IDAC_HEAT is never written by the driver
+ * and is read once when first needed.
+ */
+struct bme69x_heatr_img
+{
+    /*! IDAC_HEAT0 to IDAC_HEAT9 */
+    uint8_t idac[BME69X_LEN_HEATR_SET];
+
+    /*! RES_HEAT0 to RES_HEAT9 */
+    uint8_t res_heat[BME69X_LEN_HEATR_SET];
+
+    /*! GAS_WAIT0 to GAS_WAIT9 */
+    uint8_t gas_wait[BME69X_LEN_HEATR_SET];
+
+    /*! Bit n set if set-point n is known */
+    uint16_t valid;
+
+    /*! Read the set-points back on every data read and compare them with the image */
+    uint8_t verify;
+
+    /*! Number of set-points found to differ from the image in verify mode */
+    uint16_t mismatch;
+};
+
+/*
+ * @brief BME69X transfer batch
+ *
+ * Register writes and deferred reads collected between bme69x_batch_begin
+ * and bme69x_batch_commit, sent with as few bus transactions as possible.
+ */
+struct bme69x_batch
+{
+    /*! Nesting depth of bme69x_batch_begin, 0 outside a batch */
+    uint8_t depth;
+
+    /*! Pending register writes, in the order they were issued */
+    uint8_t wr_addr[BME69X_LEN_BATCH_WRITES];
+    uint8_t wr_data[BME69X_LEN_BATCH_WRITES];
+    uint8_t n_writes;
+
+    /*! Pending deferred reads */
+    struct bme69x_read_seg reads[BME69X_LEN_BATCH_READS];
+    uint8_t n_reads;
+};
+
 /*
  * @brief BME69X device structure
  */
@@ -966,6 +1097,9 @@ struct bme69x_dev
     /*! Write function pointer */
     bme69x_write_fptr_t write;
 
+    /*! Vectored read function pointer, NULL to read block by block */
+    bme69x_readv_fptr_t readv;
+
     /*! Delay function pointer */
     bme69x_delay_us_fptr_t delay_us;
 
@@ -974,6 +1108,15 @@ struct bme69x_dev
 
     /*! Store the info messages */
     uint8_t info_msg;
+
+    /*! Shadow register map, NULL to always read from the sensor */
+    struct bme69x_shadow *shadow;
+
+    /*! Heater register image */
+    struct bme69x_heatr_img heatr_img;
+
+    /*! Open transfer batch */
+    struct bme69x_batch batch;
 };
 
 #endif /* BME69X_DEFS_H_ */
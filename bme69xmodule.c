@@ -21,6 +21,16 @@
         } \
     } while(0)
 
+/* Run a driver call as one bus transaction, with the bus lock (and lock
+ * file) held so its transfers cannot interleave with other sensors or
+ * processes on the bus */
+#define BUS_TXN(self, ...) \
+    do { \
+        pi3g_intf_lock(&(self)->intf); \
+        __VA_ARGS__; \
+        pi3g_intf_unlock(&(self)->intf); \
+    } while(0)
+
 uint64_t time_stamp_interval_us = 0;
 uint32_t n_samples = 0;
 
@@ -35,6 +45,11 @@ FILE *bsec_conf;
 
 static PyObject *bmeError;
 
+/* Who runs the BSEC cycles of a sensor in the background */
+#define BME_ACQ_OFF       0
+#define BME_ACQ_THREAD    1 /* its own start_acquisition() thread */
+#define BME_ACQ_SCHEDULER 2 /* a bme69x.Scheduler */
+
 /* Helper functions for per-sensor config/state file paths */
 static void get_config_filename(const char *sensor_id, char *out_path, size_t max_len)
 {
@@ -46,13 +61,34 @@ static void get_state_filename(const char *sensor_id, char *out_path, size_t max
     snprintf(out_path, max_len, "conf/state_data_%s.txt", sensor_id);
 }
 
+/* Real-time options of start_acquisition() and Scheduler.start() */
+struct bme_rt_opts
+{
+    /* SCHED_FIFO priority, 0 for the default policy */
+    int priority;
+
+    /* CPU to pin the thread to, -1 for any */
+    int cpu;
+
+    /* mlockall() before starting the thread */
+    uint8_t lock_memory;
+
+    /* Spin margin of the hybrid sleep in us, -1 to calibrate it when
+     * priority is set and to just sleep otherwise */
+    int spin_us;
+
+    /* Batch the wake-ups with timer slack instead, see bme_rt_wait() */
+    uint8_t low_power;
+};
+
 typedef struct
 {
     PyObject_HEAD
-        int linux_device;
+        struct pi3g_intf intf;
     int8_t temp_offset;
     void *bsec_inst;
     struct bme69x_dev bme;
+    struct bme69x_shadow shadow;
     struct bme69x_conf conf;
     struct bme69x_heatr_conf heatr_conf;
     struct bme69x_data *data;
@@ -68,12 +104,118 @@ typedef struct
     uint16_t sample_count;
     uint8_t debug_mode;
     uint8_t i2c_addr;
+    uint8_t i2c_bus;
+    uint8_t bus_lock;
     char sensor_id[64];
+    /* Serializes the methods of this object, they wait and do bus I/O
+     * with the GIL released */
+    pthread_mutex_t lock;
+    /* Background acquisition, see start_acquisition(). acq_stop and
+     * acq_error are guarded by acq_mutex, acq_running is a BME_ACQ_* */
+    pthread_t acq_thread;
+    uint8_t acq_running;
+    uint8_t acq_stop;
+    pthread_mutex_t acq_mutex;
+    pthread_cond_t acq_cond;
+    struct pi3g_sample_ring *acq_ring;
+    atomic_uint_least64_t acq_errors;
+    const char *acq_error;
+    struct bme_rt_opts acq_rt;
+    /* Guarded by acq_mutex too */
+    uint32_t acq_spin_ns;
+    struct pi3g_wake_stats acq_wake;
+    /* next_sample() futures, oldest first, and the event loop that watches
+     * fileno() for them */
+    PyObject *waiters;
+    PyObject *waiter_loop;
+#ifdef BSEC
+    /* BSEC cycle between trigger() and collect() */
+    uint8_t split_pending;
+    int64_t split_ready_ns;
+    bsec_bme_settings_t split_settings;
+    struct pi3g_bsec_sample split_sample;
+    /* Call timing and warnings of the BSEC cycles, guarded by lock */
+    struct pi3g_bsec_timing bsec_timing;
+#endif
 } BMEObject;
 
+/* Take the object lock. Waits with the GIL released, the holder may need
+ * the GIL back before it can let go of the lock. */
+static void bme_lock(BMEObject *self)
+{
+    if (pthread_mutex_trylock(&(self->lock)) != 0)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        pthread_mutex_lock(&(self->lock));
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static void bme_unlock(BMEObject *self)
+{
+    pthread_mutex_unlock(&(self->lock));
+}
+
+/* Define the method name() as name_locked() run with the object lock held */
+#define BME_SERIALIZED_NOARGS(name) \
+    static PyObject *name(BMEObject *self, PyObject *Py_UNUSED(ignored)) \
+    { \
+        PyObject *_result; \
+        bme_lock(self); \
+        _result = name##_locked(self); \
+        bme_unlock(self); \
+        return _result; \
+    }
+
+#define BME_SERIALIZED_VARARGS(name) \
+    static PyObject *name(BMEObject *self, PyObject *args) \
+    { \
+        PyObject *_result; \
+        bme_lock(self); \
+        _result = name##_locked(self, args); \
+        bme_unlock(self); \
+        return _result; \
+    }
+
+/* Stop the acquisition thread and wait for it, called with the GIL held */
+static void bme_acq_join(BMEObject *self)
+{
+    if (self->acq_running != BME_ACQ_THREAD)
+    {
+        return;
+    }
+    pthread_mutex_lock(&(self->acq_mutex));
+    self->acq_stop = 1;
+    pthread_cond_signal(&(self->acq_cond));
+    pthread_mutex_unlock(&(self->acq_mutex));
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(self->acq_thread, NULL);
+    Py_END_ALLOW_THREADS
+    self->acq_running = BME_ACQ_OFF;
+}
+
+static int bme_waiters_fail(BMEObject *self, const char *msg);
+
 static void
 bme69x_dealloc(BMEObject *self)
 {
+    bme_acq_join(self);
+    if (bme_waiters_fail(self, "Sensor was deleted") < 0)
+    {
+        PyErr_WriteUnraisable(NULL);
+    }
+    if (self->acq_ring)
+    {
+        pi3g_sample_ring_close(self->acq_ring);
+        free(self->acq_ring);
+    }
+    Py_XDECREF(self->waiters);
+    Py_XDECREF(self->waiter_loop);
+    pi3g_intf_close(&(self->intf));
+    pthread_cond_destroy(&(self->acq_cond));
+    pthread_mutex_destroy(&(self->acq_mutex));
+    pthread_mutex_destroy(&(self->lock));
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
@@ -84,7 +226,19 @@ bme69x_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     self = (BMEObject *)type->tp_alloc(type, 0);
     if (self != NULL)
     {
-        self->linux_device = 0;
+        self->intf.transport = pi3g_get_transport("i2c");
+        self->intf.bus_nr = 0;
+        self->intf.bus = NULL;
+        self->intf.i2c_addr = 0;
+        self->intf.i2c_mode = PI3G_I2C_MODE_RW;
+        self->intf.spi_fd = -1;
+        self->intf.spi_cs = 0;
+        self->intf.spi_speed_hz = 0;
+        self->intf.fake = NULL;
+        self->intf.mux_addr = 0;
+        self->intf.mux_channel = 0;
+        self->intf.spin_ns = 0;
+        pi3g_stats_reset(&(self->intf.stats));
         self->temp_offset = 5;
 
 /*! 690 API has replace gh1 - 3 with h1 - 3, and removed H7 - no idea why!  */
@@ -120,12 +274,16 @@ bme69x_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
         self->bme.delay_us = pi3g_delay_us;
         self->bme.info_msg = 0;
         self->bme.intf = BME69X_I2C_INTF;
-        self->bme.intf_ptr = &(self->linux_device);
+        self->bme.intf_ptr = &(self->intf);
         self->bme.intf_rslt = 0;
         self->bme.mem_page = 0;
         self->bme.read = pi3g_read;
         self->bme.variant_id = 0;
         self->bme.write = pi3g_write;
+        self->bme.readv = pi3g_readv;
+        self->bme.shadow = NULL;
+        memset(&(self->bme.batch), 0, sizeof(self->bme.batch));
+        self->shadow.valid = 0;
 
         self->conf.os_hum = 0;
         self->conf.os_temp = 0;
@@ -178,6 +336,30 @@ bme69x_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
         self->op_mode = BME69X_SLEEP_MODE;
         self->sample_count = 0;
         self->debug_mode = 0;
+        self->bus_lock = 0;
+        pthread_mutex_init(&(self->lock), NULL);
+
+        /* The acquisition thread sleeps on the clock of next_call */
+        pthread_condattr_t condattr;
+        pthread_condattr_init(&condattr);
+        pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+        pthread_cond_init(&(self->acq_cond), &condattr);
+        pthread_condattr_destroy(&condattr);
+        pthread_mutex_init(&(self->acq_mutex), NULL);
+        self->acq_running = BME_ACQ_OFF;
+        self->acq_stop = 0;
+        self->acq_ring = NULL;
+        atomic_init(&(self->acq_errors), 0);
+        self->acq_error = NULL;
+        self->acq_spin_ns = 0;
+        memset(&(self->acq_wake), 0, sizeof(self->acq_wake));
+        self->waiters = NULL;
+        self->waiter_loop = NULL;
+#ifdef BSEC
+        self->split_pending = 0;
+        self->split_ready_ns = 0;
+        pi3g_bsec_timing_reset(&(self->bsec_timing));
+#endif
     }
     return (PyObject *)self;
 }
@@ -185,21 +367,42 @@ bme69x_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 static int
 bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
 {
-    static char *kwlist[] = {"i2c_addr", "i2c_bus", "debug_mode", "sensor_name", NULL};
+    static char *kwlist[] = {"i2c_addr", "i2c_bus", "debug_mode", "sensor_name", "i2c_rdwr", "shadow_regs",
+                             "transport", "spi_bus", "spi_cs", "spi_speed_hz", "bus_lock",
+                             "mux_addr", "mux_channel", NULL};
     
     uint8_t i2c_addr = 0;
     uint8_t i2c_bus = 1;
     uint8_t debug_mode = 0;
     const char *sensor_name = NULL;
+    uint8_t i2c_rdwr = 1;
+    uint8_t shadow_regs = 0;
+    const char *transport = "i2c";
+    uint8_t spi_bus = 0;
+    uint8_t spi_cs = 0;
+    uint32_t spi_speed_hz = 8000000;
+    uint8_t bus_lock = 0;
+    uint8_t mux_addr = 0;
+    uint8_t mux_channel = 0;
     
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "b|bbs", kwlist, &i2c_addr, &i2c_bus, &debug_mode, &sensor_name))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "b|bbsbbsbbIbbb", kwlist, &i2c_addr, &i2c_bus, &debug_mode, &sensor_name, &i2c_rdwr, &shadow_regs,
+                                     &transport, &spi_bus, &spi_cs, &spi_speed_hz, &bus_lock,
+                                     &mux_addr, &mux_channel))
     {
         perror("Failed to parse arguments");
         return -1;
     }
+
+    self->intf.transport = pi3g_get_transport(transport);
+    if (self->intf.transport == NULL)
+    {
+        PyErr_SetString(bmeError, "Unknown transport, use 'i2c', 'spi' or 'fake'");
+        return -1;
+    }
     
     self->i2c_addr = i2c_addr;
     self->debug_mode = debug_mode;
+    self->bus_lock = bus_lock;
     
     /* Generate sensor_id: use provided name or auto-generate from address */
     if (sensor_name)
@@ -211,35 +414,64 @@ bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
         snprintf(self->sensor_id, sizeof(self->sensor_id), "sensor_0x%02x", i2c_addr);
     }
     
-    /* Open I2C device */
-    char i2c_path[32];
-    snprintf(i2c_path, sizeof(i2c_path), "/dev/i2c-%d", i2c_bus);
-    
-    self->linux_device = open(i2c_path, O_RDWR);
-    if (self->linux_device < 0)
+    /* Share the I2C bus handle with other sensors on the same bus, every
+     * transfer carries the sensor address so no I2C_SLAVE pinning is needed */
+    self->i2c_bus = i2c_bus;
+    self->intf.bus_nr = (self->intf.transport->id == PI3G_TRANSPORT_I2C) ? i2c_bus : spi_bus;
+    self->intf.i2c_addr = i2c_addr;
+    self->intf.spi_cs = spi_cs;
+    self->intf.mux_addr = (self->intf.transport->id == PI3G_TRANSPORT_I2C) ? mux_addr : 0;
+    self->intf.mux_channel = mux_channel;
+    if (self->intf.mux_addr != 0 &&
+        (mux_addr < PI3G_MUX_ADDR_MIN || mux_addr >= PI3G_MUX_ADDR_MIN + PI3G_MUX_N || mux_channel >= PI3G_MUX_N_CHANNELS))
+    {
+        PyErr_SetString(bmeError, "mux_addr must be 0x70 to 0x77 and mux_channel 0 to 7");
+        return -1;
+    }
+    self->intf.spi_speed_hz = spi_speed_hz;
+    if (pi3g_intf_open(&(self->intf)) != 0)
     {
-        perror("Failed to open I2C port");
-        PyErr_SetString(bmeError, "Failed to open I2C device port");
+        perror("Failed to open device port");
+        PyErr_SetString(bmeError, "Failed to open device port");
         return -1;
     }
 
-    /* Set I2C slave address */
-    if (ioctl(self->linux_device, I2C_SLAVE, i2c_addr) < 0)
+    /* Register reads as one I2C_RDWR transaction unless disabled or unsupported */
+    if (self->intf.transport->id == PI3G_TRANSPORT_I2C)
+    {
+        pi3g_set_i2c_mode(&(self->intf), i2c_rdwr ? PI3G_I2C_MODE_RDWR : PI3G_I2C_MODE_RW);
+
+        /* Arbitrate the bus with other processes through its lock file */
+        if (bus_lock && pi3g_bus_enable_flock(self->intf.bus) != 0)
+        {
+            pi3g_intf_close(&(self->intf));
+            PyErr_SetString(bmeError, "Failed to open bus lock file");
+            return -1;
+        }
+    }
+    if (self->debug_mode == 1)
     {
-        printf("WARNING: I2C_SLAVE ioctl failed for address 0x%02x (errno=%d)\n", i2c_addr, errno);
-        perror("I2C_SLAVE");
-        /* Continue anyway - BME69X might still work via I2C_RDWR */
+        printf("TRANSPORT %s\n", self->intf.transport->name);
+        if (self->intf.transport->id == PI3G_TRANSPORT_I2C)
+        {
+            printf("I2C MODE %s\n", self->intf.i2c_mode == PI3G_I2C_MODE_RDWR ? "I2C_RDWR" : "WRITE/READ");
+        }
     }
     
     /* Initialize BME69X sensor */
-    self->bme.intf = BME69X_I2C_INTF;
+    self->bme.intf = self->intf.transport->intf;
     self->bme.amb_temp = 0;
-    self->bme.read = pi3g_read;
-    self->bme.write = pi3g_write;
+    self->bme.read = self->intf.transport->read;
+    self->bme.write = self->intf.transport->write;
+    self->bme.readv = self->intf.transport->readv;
     self->bme.delay_us = pi3g_delay_us;
 
+    /* Serve control register reads from memory, only valid while this object is the only writer */
+    self->shadow.valid = 0;
+    self->bme.shadow = shadow_regs ? &(self->shadow) : NULL;
+
     self->rslt = BME69X_OK;
-    self->rslt = bme69x_init(&(self->bme));
+    BUS_TXN(self, self->rslt = bme69x_init(&(self->bme)));
     if (self->rslt == BME69X_OK)
     {
         if (self->debug_mode == 1)
@@ -258,7 +490,7 @@ bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
     else
     {
         perror("initialize BME69X");
-        close(self->linux_device);
+        pi3g_intf_close(&(self->intf));
         PyErr_SetString(bmeError, "Could not initialize BME69X");
         return -1;
     }
@@ -267,13 +499,13 @@ bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
     {
         size_t bsec_inst_size = bsec_get_instance_size();
         if (bsec_inst_size == 0) {
-            close(self->linux_device);
+            pi3g_intf_close(&(self->intf));
             PyErr_SetString(bmeError, "BSEC instance size is zero");
             return -1;
         }
         self->bsec_inst = malloc(bsec_inst_size);
         if (!self->bsec_inst) {
-            close(self->linux_device);
+            pi3g_intf_close(&(self->intf));
             PyErr_SetString(bmeError, "Failed to allocate BSEC instance");
             return -1;
         }
@@ -282,7 +514,7 @@ bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
         if (self->rslt != BSEC_OK)
         {
             free(self->bsec_inst);
-            close(self->linux_device);
+            pi3g_intf_close(&(self->intf));
             PyErr_SetString(bmeError, "Failed to initialize BSEC");
             return -1;
         }
@@ -293,11 +525,15 @@ bme69x_init_type(BMEObject *self, PyObject *args, PyObject *kwds)
     {
         printf("INITIALIZED BSEC\nBSEC VERSION: %d.%d.%d.%d\n", version.major, version.minor, version.major_bugfix, version.minor_bugfix);
     }
-#endif    return 0;
+#endif
+    return 0;
 }
 
 static PyMemberDef bme69x_members[] = {
-    {"linux_device_handle", T_INT, offsetof(BMEObject, linux_device), 0, "Linux file descriptor of the sensor device"},
+    {"i2c_rdwr", T_UBYTE, offsetof(BMEObject, intf.i2c_mode), READONLY, "1 if register reads use a single I2C_RDWR transaction"},
+    {"shadow_regs_valid", T_UBYTE, offsetof(BMEObject, shadow.valid), READONLY, "Bit mask of control registers (0x6E to 0x75) currently served from the shadow register map"},
+    {"heatr_verify", T_UBYTE, offsetof(BMEObject, bme.heatr_img.verify), 0, "1 to read the heater set-points back on every data read instead of using the written values"},
+    {"heatr_mismatch", T_USHORT, offsetof(BMEObject, bme.heatr_img.mismatch), READONLY, "number of heater set-points found to differ from the written values (heatr_verify)"},
     {"temp_offset", T_BYTE, offsetof(BMEObject, temp_offset), 0, "temperature offset to be subtracted from 25 degC"},
      /* Expose only simple fields to Python. Embedded C structs are not exposed as PyObject*
          because that would let Python treat raw struct memory as PyObject pointers and
@@ -314,8 +550,24 @@ static PyMemberDef bme69x_members[] = {
     {NULL},
 };
 
+static PyObject *bme_get_linux_device_handle(BMEObject *self, void *closure)
+{
+    return Py_BuildValue("i", pi3g_intf_fd(&(self->intf)));
+}
+
+static PyObject *bme_get_transport(BMEObject *self, void *closure)
+{
+    return Py_BuildValue("s", self->intf.transport->name);
+}
+
+static PyGetSetDef bme69x_getset[] = {
+    {"linux_device_handle", (getter)bme_get_linux_device_handle, NULL, "Linux file descriptor of the shared I2C bus or the spidev device", NULL},
+    {"transport", (getter)bme_get_transport, NULL, "Register transport in use: 'i2c', 'spi' or 'fake'", NULL},
+    {NULL},
+};
+
 #ifdef BSEC
-static PyObject *bme_set_sample_rate(BMEObject *self, PyObject *args)
+static PyObject *bme_set_sample_rate_locked(BMEObject *self, PyObject *args)
 {
     float sample_rate;
 
@@ -327,19 +579,22 @@ static PyObject *bme_set_sample_rate(BMEObject *self, PyObject *args)
 
     return Py_BuildValue("i", bsec_set_sample_rate(self->bsec_inst, sample_rate));
 }
+
+BME_SERIALIZED_VARARGS(bme_set_sample_rate)
 #endif
 
-static PyObject *bme_init_bme69x(BMEObject *self)
+static PyObject *bme_init_bme69x_locked(BMEObject *self)
 {
     // Initialize BME69X sensor
-    self->bme.intf = BME69X_I2C_INTF;
+    self->bme.intf = self->intf.transport->intf;
     self->bme.amb_temp = 25;
-    self->bme.read = pi3g_read;
-    self->bme.write = pi3g_write;
+    self->bme.read = self->intf.transport->read;
+    self->bme.write = self->intf.transport->write;
+    self->bme.readv = self->intf.transport->readv;
     self->bme.delay_us = pi3g_delay_us;
 
     self->rslt = BME69X_OK;
-    self->rslt = bme69x_init(&(self->bme));
+    BUS_TXN(self, self->rslt = bme69x_init(&(self->bme)));
     if (self->rslt == BME69X_OK)
     {
         if (self->debug_mode == 1)
@@ -360,7 +615,9 @@ static PyObject *bme_init_bme69x(BMEObject *self)
     return Py_BuildValue("i", self->rslt);
 }
 
-static PyObject *bme_print_dur_prof(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_init_bme69x)
+
+static PyObject *bme_print_dur_prof_locked(BMEObject *self)
 {
     for (uint8_t i = 0; i < self->heatr_conf.profile_len; i++)
     {
@@ -371,25 +628,31 @@ static PyObject *bme_print_dur_prof(BMEObject *self)
     return Py_BuildValue("s", "None");
 }
 
-static PyObject *bme_enable_debug_mode(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_print_dur_prof)
+
+static PyObject *bme_enable_debug_mode_locked(BMEObject *self)
 {
     self->debug_mode = 1;
     return Py_BuildValue("s", "Disabled debug mode");
 }
 
-static PyObject *bme_disable_debug_mode(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_enable_debug_mode)
+
+static PyObject *bme_disable_debug_mode_locked(BMEObject *self)
 {
     self->debug_mode = 0;
     return Py_BuildValue("s", "Enabled debug mode");
 }
 
-static PyObject *bme_get_sensor_id(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_disable_debug_mode)
+
+static PyObject *bme_get_sensor_id_locked(BMEObject *self)
 {
     uint8_t id_regs[4];
     uint32_t len = 4;
     uint32_t uid;
     int8_t rslt;
-    rslt = bme69x_get_regs(BME69X_REG_UNIQUE_ID, (uint8_t *) &id_regs, len, &(self->bme));
+    BUS_TXN(self, rslt = bme69x_get_regs(BME69X_REG_UNIQUE_ID, (uint8_t *) &id_regs, len, &(self->bme)));
     if (rslt < BME69X_OK)
     {
         PyErr_SetString(bmeError, "Failed to read sensor id register");
@@ -401,7 +664,9 @@ static PyObject *bme_get_sensor_id(BMEObject *self)
     return Py_BuildValue("i", uid);
 }
 
-static PyObject *bme_set_temp_offset(BMEObject *self, PyObject *args)
+BME_SERIALIZED_NOARGS(bme_get_sensor_id)
+
+static PyObject *bme_set_temp_offset_locked(BMEObject *self, PyObject *args)
 {
     int t_offs;
     if (!PyArg_ParseTuple(args, "i", &t_offs))
@@ -421,8 +686,10 @@ static PyObject *bme_set_temp_offset(BMEObject *self, PyObject *args)
     return Py_BuildValue("i", 0);
 }
 
+BME_SERIALIZED_VARARGS(bme_set_temp_offset)
+
 #ifdef BSEC
-static PyObject *bme_subscribe_gas_estimates(BMEObject *self, PyObject *args)
+static PyObject *bme_subscribe_gas_estimates_locked(BMEObject *self, PyObject *args)
 {
     uint8_t n_requested_virtual_sensors;
     if (!PyArg_ParseTuple(args, "b", &n_requested_virtual_sensors))
@@ -449,7 +716,9 @@ static PyObject *bme_subscribe_gas_estimates(BMEObject *self, PyObject *args)
     return Py_BuildValue("i", self->rslt);
 }
 
-static PyObject *bme_subscribe_ai_classes(BMEObject *self)
+BME_SERIALIZED_VARARGS(bme_subscribe_gas_estimates)
+
+static PyObject *bme_subscribe_ai_classes_locked(BMEObject *self)
 {
     uint8_t n_requested_virtual_sensors;
     n_requested_virtual_sensors = 5;
@@ -509,29 +778,114 @@ static PyObject *bme_subscribe_ai_classes(BMEObject *self)
 
     return Py_BuildValue("i", self->rslt);
 }
+
+BME_SERIALIZED_NOARGS(bme_subscribe_ai_classes)
 #endif
 
-static PyObject *bme_get_chip_id(BMEObject *self)
+static PyObject *bme_get_chip_id_locked(BMEObject *self)
 {
     return Py_BuildValue("i", self->bme.chip_id);
 }
 
-static PyObject *bme_close_i2c(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_get_chip_id)
+
+static PyObject *bme_close_i2c_locked(BMEObject *self)
+{
+    if (self->acq_running)
+    {
+        PyErr_SetString(bmeError, "Acquisition is running, call stop_acquisition() first");
+        return NULL;
+    }
+    /* Only the last sensor on an I2C bus really closes the fd */
+    pi3g_intf_close(&(self->intf));
+    return Py_BuildValue("i", 0);
+}
+
+BME_SERIALIZED_NOARGS(bme_close_i2c)
+
+/* Log2 histogram as list, see PI3G_STATS_N_BUCKETS */
+static PyObject *bme_hist_to_list(const uint64_t *hist)
+{
+    PyObject *list = PyList_New(PI3G_STATS_N_BUCKETS);
+    if (list == NULL)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < PI3G_STATS_N_BUCKETS; i++)
+    {
+        PyList_SET_ITEM(list, i, Py_BuildValue("K", (unsigned long long)hist[i]));
+    }
+    return list;
+}
+
+/* Transfer counters of this sensor as dict, times in us. latency_hist[i]
+ * counts the transfers that took [2^i, 2^(i+1)) us, the first bucket also
+ * the faster ones and the last bucket also the slower ones. */
+static PyObject *bme_get_bus_stats_locked(BMEObject *self)
+{
+    struct pi3g_stats *stats = &(self->intf.stats);
+    PyObject *hist = bme_hist_to_list(stats->latency_hist);
+    if (hist == NULL)
+    {
+        return NULL;
+    }
+
+    PyObject *pydata = PyDict_New();
+    DICT_SET_ITEM(pydata, "transport", Py_BuildValue("s", self->intf.transport->name));
+    DICT_SET_ITEM(pydata, "reads", Py_BuildValue("K", (unsigned long long)stats->reads));
+    DICT_SET_ITEM(pydata, "writes", Py_BuildValue("K", (unsigned long long)stats->writes));
+    DICT_SET_ITEM(pydata, "bytes_read", Py_BuildValue("K", (unsigned long long)stats->bytes_read));
+    DICT_SET_ITEM(pydata, "bytes_written", Py_BuildValue("K", (unsigned long long)stats->bytes_written));
+    DICT_SET_ITEM(pydata, "failures", Py_BuildValue("K", (unsigned long long)stats->failures));
+    DICT_SET_ITEM(pydata, "total_time_us", Py_BuildValue("d", stats->time_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "max_time_us", Py_BuildValue("d", stats->max_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "latency_hist", hist);
+
+    /* Shared by all sensors on the I2C bus */
+    if (self->intf.bus != NULL)
+    {
+        struct pi3g_lock_stats lock_stats;
+        pi3g_bus_get_lock_stats(self->intf.bus, &lock_stats);
+
+        PyObject *pylock = PyDict_New();
+        DICT_SET_ITEM(pylock, "flock", Py_BuildValue("i", self->intf.bus->flock_fd >= 0 ? 1 : 0));
+        DICT_SET_ITEM(pylock, "acquisitions", Py_BuildValue("K", (unsigned long long)lock_stats.acquisitions));
+        DICT_SET_ITEM(pylock, "contended", Py_BuildValue("K", (unsigned long long)lock_stats.contended));
+        DICT_SET_ITEM(pylock, "total_wait_us", Py_BuildValue("d", lock_stats.wait_ns / 1000.0));
+        DICT_SET_ITEM(pylock, "max_wait_us", Py_BuildValue("d", lock_stats.max_wait_ns / 1000.0));
+        DICT_SET_ITEM(pylock, "total_hold_us", Py_BuildValue("d", lock_stats.hold_ns / 1000.0));
+        DICT_SET_ITEM(pylock, "max_hold_us", Py_BuildValue("d", lock_stats.max_hold_ns / 1000.0));
+        DICT_SET_ITEM(pydata, "bus_lock", pylock);
+        DICT_SET_ITEM(pydata, "mux_switches", Py_BuildValue("K", (unsigned long long)pi3g_bus_get_mux_switches(self->intf.bus)));
+    }
+    return pydata;
+}
+
+BME_SERIALIZED_NOARGS(bme_get_bus_stats)
+
+static PyObject *bme_reset_bus_stats_locked(BMEObject *self)
 {
-    return Py_BuildValue("i", close(*((int *)self->bme.intf_ptr)));
+    pi3g_stats_reset(&(self->intf.stats));
+    if (self->intf.bus != NULL)
+    {
+        pi3g_bus_reset_stats(self->intf.bus);
+    }
+    return Py_BuildValue("i", 0);
 }
 
-static PyObject *bme_open_i2c(BMEObject *self, PyObject *args)
+BME_SERIALIZED_NOARGS(bme_reset_bus_stats)
+
+static PyObject *bme_open_i2c_locked(BMEObject *self, PyObject *args)
 {
-    close(*((int *)self->bme.intf_ptr));
-    self->linux_device = open(I2C_PORT_1, O_RDWR);
-    if (self->linux_device < 0)
+    pi3g_intf_close(&(self->intf));
+    if (pi3g_intf_open(&(self->intf)) != 0)
     {
-        perror("Failed to open I2C port");
-        PyErr_SetString(bmeError, "Failed to open I2C device port");
+        perror("Failed to open device port");
+        PyErr_SetString(bmeError, "Failed to open device port");
         return (PyObject *)NULL;
     }
-    self->bme.intf_ptr = &(self->linux_device);
+    self->bme.intf_ptr = &(self->intf);
+    self->shadow.valid = 0;
     Py_ssize_t size = PyTuple_Size(args);
     uint8_t i2c_addr;
 
@@ -542,23 +896,90 @@ static PyObject *bme_open_i2c(BMEObject *self, PyObject *args)
             PyErr_SetString(bmeError, "Failed to parse I2C address");
             return (PyObject *)NULL;
         }
-        else if (ioctl(*((int *)self->bme.intf_ptr), I2C_SLAVE, i2c_addr) < 0)
+        self->intf.i2c_addr = i2c_addr;
+        if (self->intf.transport->id == PI3G_TRANSPORT_I2C)
         {
-            PyErr_SetString(bmeError, "Failed to open I2C address");
-            return (PyObject *)NULL;
+            pi3g_set_i2c_mode(&(self->intf), self->intf.i2c_mode);
         }
     }
     else
     {
         PyErr_SetString(bmeError, "Argument must be i2c_addr: int");
-        close(*((int *)self->bme.intf_ptr));
+        pi3g_intf_close(&(self->intf));
         return (PyObject *)NULL;
     }
 
     return Py_BuildValue("i", 0);
 }
 
-static PyObject *bme_get_variant(BMEObject *self)
+BME_SERIALIZED_VARARGS(bme_open_i2c)
+
+/* Reopen the device after a bus error and bring the sensor back to the
+ * configured settings. Calibration data, BSEC instance and state, sample
+ * count and BSEC scheduling are kept, so no new calibration read or BSEC
+ * warm-up is needed. */
+static PyObject *bme_reconnect_locked(BMEObject *self)
+{
+    uint8_t i2c_mode = self->intf.i2c_mode;
+
+    pi3g_intf_close(&(self->intf));
+    if (pi3g_intf_open(&(self->intf)) != 0)
+    {
+        perror("Failed to open device port");
+        PyErr_SetString(bmeError, "Failed to reopen device port");
+        return (PyObject *)NULL;
+    }
+    self->bme.intf_ptr = &(self->intf);
+
+    if (self->intf.transport->id == PI3G_TRANSPORT_I2C)
+    {
+        /* Other sensors keep the bus open, its fd may predate the reset */
+        if (pi3g_bus_reopen(self->intf.bus) != 0 ||
+            (self->bus_lock && pi3g_bus_enable_flock(self->intf.bus) != 0))
+        {
+            pi3g_intf_close(&(self->intf));
+            PyErr_SetString(bmeError, "Failed to reopen device port");
+            return (PyObject *)NULL;
+        }
+        pi3g_set_i2c_mode(&(self->intf), i2c_mode);
+    }
+
+    BUS_TXN(self, self->rslt = bme69x_reinit(&(self->bme)));
+    if (self->rslt != BME69X_OK)
+    {
+        perror("bme69x_reinit");
+        return Py_BuildValue("i", self->rslt);
+    }
+
+    BUS_TXN(self, self->rslt = bme69x_set_conf(&(self->conf), &(self->bme)));
+    if (self->rslt == BME69X_OK && self->op_mode == BME69X_FORCED_MODE)
+    {
+        BUS_TXN(self, self->rslt = bme69x_set_heatr_conf(BME69X_FORCED_MODE, &(self->heatr_conf), &(self->bme)));
+    }
+    else if (self->rslt == BME69X_OK && self->op_mode != BME69X_SLEEP_MODE)
+    {
+        /* Parallel and sequential mode measure on their own again */
+        BUS_TXN(self, self->rslt = bme69x_set_heatr_conf(self->op_mode, &(self->heatr_conf), &(self->bme)));
+        if (self->rslt == BME69X_OK)
+        {
+            BUS_TXN(self, self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme)));
+        }
+    }
+    if (self->rslt != BME69X_OK)
+    {
+        perror("reconnect");
+    }
+    if (self->debug_mode == 1)
+    {
+        printf("RECONNECTED BME69X\n");
+    }
+
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_NOARGS(bme_reconnect)
+
+static PyObject *bme_get_variant_locked(BMEObject *self)
 {
     char *variant = "";
     if (self->bme.variant_id == BME69X_VARIANT_GAS_LOW)
@@ -580,7 +1001,9 @@ static PyObject *bme_get_variant(BMEObject *self)
     return Py_BuildValue("s", variant);
 }
 
-static PyObject *bme_set_conf(BMEObject *self, PyObject *args)
+BME_SERIALIZED_NOARGS(bme_get_variant)
+
+static PyObject *bme_set_conf_locked(BMEObject *self, PyObject *args)
 {
     Py_ssize_t size = PyTuple_Size(args);
     uint8_t c[size];
@@ -589,33 +1012,35 @@ static PyObject *bme_set_conf(BMEObject *self, PyObject *args)
     {
     case 1:
         PyArg_ParseTuple(args, "b", &c[0]);
-        self->rslt = pi3g_set_conf(c[0], self->conf.os_pres, self->conf.os_temp, self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(c[0], self->conf.os_pres, self->conf.os_temp, self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode));
         break;
     case 2:
         PyArg_ParseTuple(args, "bb", &c[0], &c[1]);
-        self->rslt = pi3g_set_conf(c[0], c[1], self->conf.os_temp, self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(c[0], c[1], self->conf.os_temp, self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode));
         break;
     case 3:
         PyArg_ParseTuple(args, "bbb", &c[0], &c[1], &c[2]);
-        self->rslt = pi3g_set_conf(c[0], c[1], c[2], self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(c[0], c[1], c[2], self->conf.filter, self->conf.odr, &(self->conf), &(self->bme), self->debug_mode));
         break;
     case 4:
         PyArg_ParseTuple(args, "bbbb", &c[0], &c[1], &c[2], &c[3]);
-        self->rslt = pi3g_set_conf(c[0], c[1], c[2], c[3], self->conf.odr, &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(c[0], c[1], c[2], c[3], self->conf.odr, &(self->conf), &(self->bme), self->debug_mode));
         break;
     case 5:
         PyArg_ParseTuple(args, "bbbbb", &c[0], &c[1], &c[2], &c[3], &c[4]);
-        self->rslt = pi3g_set_conf(c[0], c[1], c[2], c[3], c[4], &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(c[0], c[1], c[2], c[3], c[4], &(self->conf), &(self->bme), self->debug_mode));
         break;
     default:
-        self->rslt = pi3g_set_conf(BME69X_OS_16X, BME69X_OS_1X, BME69X_OS_2X, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode);
+        BUS_TXN(self, self->rslt = pi3g_set_conf(BME69X_OS_16X, BME69X_OS_1X, BME69X_OS_2X, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode));
         break;
     }
 
     return Py_BuildValue("b", self->rslt);
 }
 
-static PyObject *bme_set_heatr_conf(BMEObject *self, PyObject *args)
+BME_SERIALIZED_VARARGS(bme_set_conf)
+
+static PyObject *bme_set_heatr_conf_locked(BMEObject *self, PyObject *args)
 {
     uint8_t enable;
     PyObject *temp_prof_obj;
@@ -642,14 +1067,20 @@ static PyObject *bme_set_heatr_conf(BMEObject *self, PyObject *args)
         t_dev.amb_temp = self->bme.amb_temp;
         t_dev.read = self->bme.read;
         t_dev.write = self->bme.write;
+        t_dev.readv = self->bme.readv;
         t_dev.delay_us = self->bme.delay_us;
-        t_dev.intf_ptr = &(self->linux_device);
+        t_dev.intf_ptr = &(self->intf);
         t_dev.variant_id = self->bme.variant_id;
         t_dev.calib = self->bme.calib;
         t_dev.info_msg = self->bme.info_msg;
         t_dev.intf_rslt = 0;
         t_dev.mem_page = self->bme.mem_page;
-        self->rslt = pi3g_set_heater_conf_fm(enable, heatr_temp, heatr_dur, &(self->heatr_conf), &t_dev, self->debug_mode);
+        t_dev.shadow = self->bme.shadow;
+        t_dev.heatr_img = self->bme.heatr_img;
+        BUS_TXN(self, self->rslt = pi3g_set_heater_conf_fm(enable, heatr_temp, heatr_dur, &(self->heatr_conf), &t_dev, self->debug_mode));
+        /* Over SPI the heater writes may have switched the memory page */
+        self->bme.mem_page = t_dev.mem_page;
+        self->bme.heatr_img = t_dev.heatr_img;
     }
     else
     {
@@ -702,7 +1133,7 @@ static PyObject *bme_set_heatr_conf(BMEObject *self, PyObject *args)
 
         if (self->op_mode == BME69X_PARALLEL_MODE)
         {
-            self->rslt = pi3g_set_heater_conf_pm(enable, temp_prof, dur_prof, (uint8_t)temp_size, &(self->conf), &(self->heatr_conf), &(self->bme), self->debug_mode);
+            BUS_TXN(self, self->rslt = pi3g_set_heater_conf_pm(enable, temp_prof, dur_prof, (uint8_t)temp_size, &(self->conf), &(self->heatr_conf), &(self->bme), self->debug_mode));
             printf("DUR PROF AFTER PI3G\n");
             for (uint8_t i = 0; i < self->heatr_conf.profile_len; i++)
             {
@@ -712,7 +1143,7 @@ static PyObject *bme_set_heatr_conf(BMEObject *self, PyObject *args)
         }
         else if (self->op_mode == BME69X_SEQUENTIAL_MODE)
         {
-            self->rslt = pi3g_set_heater_conf_sm(enable, temp_prof, dur_prof, (uint8_t)temp_size, &(self->heatr_conf), &(self->bme), self->debug_mode);
+            BUS_TXN(self, self->rslt = pi3g_set_heater_conf_sm(enable, temp_prof, dur_prof, (uint8_t)temp_size, &(self->heatr_conf), &(self->bme), self->debug_mode));
         }
         else
         {
@@ -723,9 +1154,61 @@ static PyObject *bme_set_heatr_conf(BMEObject *self, PyObject *args)
     return Py_BuildValue("i", self->rslt);
 }
 
-static PyObject *bme_get_data(BMEObject *self)
+BME_SERIALIZED_VARARGS(bme_set_heatr_conf)
+
+// Internal function to turn a forced mode sample in self->data[0] into a dict
+static PyObject *bme_forced_data_to_dict(BMEObject *self)
+{
+    self->sample_count++;
+    self->bme.amb_temp = self->data[0].temperature - self->temp_offset;
+
+    PyObject *pydata = PyDict_New();
+    DICT_SET_ITEM(pydata, "sample_nr", Py_BuildValue("i", self->sample_count));
+    DICT_SET_ITEM(pydata, "timestamp", Py_BuildValue("i", self->time_ms));
+    DICT_SET_ITEM(pydata, "raw_temperature", Py_BuildValue("d", self->data[0].temperature));
+    DICT_SET_ITEM(pydata, "raw_pressure", Py_BuildValue("d", self->data[0].pressure / 100));
+    DICT_SET_ITEM(pydata, "raw_humidity", Py_BuildValue("d", self->data[0].humidity));
+    DICT_SET_ITEM(pydata, "raw_gas", Py_BuildValue("d", self->data[0].gas_resistance / 1000));
+    DICT_SET_ITEM(pydata, "status", Py_BuildValue("i", self->data[0].status));
+    return pydata;
+}
+
+/* One parallel/sequential mode field as dict */
+static PyObject *bme_field_to_dict(BMEObject *self, const struct bme69x_data *data)
+{
+    PyObject *field = PyDict_New();
+    DICT_SET_ITEM(field, "sample_nr", Py_BuildValue("i", self->sample_count));
+    DICT_SET_ITEM(field, "timestamp", Py_BuildValue("i", self->time_ms));
+    DICT_SET_ITEM(field, "raw_temperature", Py_BuildValue("d", data->temperature));
+    DICT_SET_ITEM(field, "raw_pressure", Py_BuildValue("d", data->pressure / 100));
+    DICT_SET_ITEM(field, "raw_humidity", Py_BuildValue("d", data->humidity));
+    DICT_SET_ITEM(field, "raw_gas", Py_BuildValue("d", data->gas_resistance / 1000));
+    DICT_SET_ITEM(field, "gas_index", Py_BuildValue("i", data->gas_index));
+    DICT_SET_ITEM(field, "meas_index", Py_BuildValue("i", data->meas_index));
+    DICT_SET_ITEM(field, "status", Py_BuildValue("i", data->status));
+    return field;
+}
+
+/* Time until the next field in parallel or sequential mode, 0 in other
+ * modes */
+static uint32_t bme_field_period(BMEObject *self)
+{
+    if (self->op_mode == BME69X_PARALLEL_MODE)
+    {
+        return bme69x_get_meas_dur(BME69X_PARALLEL_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.shared_heatr_dur * 1000);
+    }
+    if (self->op_mode == BME69X_SEQUENTIAL_MODE)
+    {
+        return bme69x_get_meas_dur(BME69X_SEQUENTIAL_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.heatr_dur_prof[0] * 1000);
+    }
+    return 0;
+}
+
+static PyObject *bme_get_data_locked(BMEObject *self)
 {
-    self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme));
+    Py_BEGIN_ALLOW_THREADS
+    BUS_TXN(self, self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme)));
+    Py_END_ALLOW_THREADS
 
     if (self->rslt != BME69X_OK)
     {
@@ -734,25 +1217,20 @@ static PyObject *bme_get_data(BMEObject *self)
 
     if (self->op_mode == BME69X_FORCED_MODE)
     {
+        Py_BEGIN_ALLOW_THREADS
+        /* Sleep to just before the end of the measurement, then poll for it */
         self->del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.heatr_dur * 1000);
-        self->bme.delay_us(self->del_period, self->bme.intf_ptr);
+        if (bme69x_wait_data(self->del_period, &(self->bme)) < 0)
+        {
+            perror("bme69x_wait_data");
+        }
         self->time_ms = pi3g_timestamp_ms();
 
-        self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme));
+        BUS_TXN(self, self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme)));
+        Py_END_ALLOW_THREADS
         if (self->rslt == BME69X_OK && self->n_fields > 0)
         {
-            self->sample_count++;
-            self->bme.amb_temp = self->data[0].temperature - self->temp_offset;
-
-            PyObject *pydata = PyDict_New();
-            DICT_SET_ITEM(pydata, "sample_nr", Py_BuildValue("i", self->sample_count));
-            DICT_SET_ITEM(pydata, "timestamp", Py_BuildValue("i", self->time_ms));
-            DICT_SET_ITEM(pydata, "raw_temperature", Py_BuildValue("d", self->data[0].temperature));
-            DICT_SET_ITEM(pydata, "raw_pressure", Py_BuildValue("d", self->data[0].pressure / 100));
-            DICT_SET_ITEM(pydata, "raw_humidity", Py_BuildValue("d", self->data[0].humidity));
-            DICT_SET_ITEM(pydata, "raw_gas", Py_BuildValue("d", self->data[0].gas_resistance / 1000));
-            DICT_SET_ITEM(pydata, "status", Py_BuildValue("i", self->data[0].status));
-            return pydata;
+            return bme_forced_data_to_dict(self);
         }
     }
     else
@@ -761,22 +1239,17 @@ static PyObject *bme_get_data(BMEObject *self)
         uint8_t counter = 0;
         while (counter < self->heatr_conf.profile_len)
         {
-            if (self->op_mode == BME69X_PARALLEL_MODE)
-            {
-                self->del_period = bme69x_get_meas_dur(BME69X_PARALLEL_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.shared_heatr_dur * 1000);
-            }
-            else if (self->op_mode == BME69X_SEQUENTIAL_MODE)
-            {
-                self->del_period = bme69x_get_meas_dur(BME69X_SEQUENTIAL_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.heatr_dur_prof[0] * 1000);
-            }
-            else
+            self->del_period = bme_field_period(self);
+            if (self->del_period == 0)
             {
                 PyErr_SetString(bmeError, "Failed to receive data");
                 return (PyObject *)NULL;
             }
+            Py_BEGIN_ALLOW_THREADS
             self->bme.delay_us(self->del_period, self->bme.intf_ptr);
 
-            self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme));
+            BUS_TXN(self, self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme)));
+            Py_END_ALLOW_THREADS
             if (self->rslt < 0)
             {
                 perror("bme69x_get_data");
@@ -787,18 +1260,8 @@ static PyObject *bme_get_data(BMEObject *self)
             {
                 if (self->data[i].status == BME69X_VALID_DATA)
                 {
-                    PyObject *field = PyDict_New();
                     self->time_ms = pi3g_timestamp_ms();
-                    DICT_SET_ITEM(field, "sample_nr", Py_BuildValue("i", self->sample_count));
-                    DICT_SET_ITEM(field, "timestamp", Py_BuildValue("i", self->time_ms));
-                    DICT_SET_ITEM(field, "raw_temperature", Py_BuildValue("d", self->data[i].temperature));
-                    DICT_SET_ITEM(field, "raw_pressure", Py_BuildValue("d", self->data[i].pressure / 100));
-                    DICT_SET_ITEM(field, "raw_humidity", Py_BuildValue("d", self->data[i].humidity));
-                    DICT_SET_ITEM(field, "raw_gas", Py_BuildValue("d", self->data[i].gas_resistance / 1000));
-                    DICT_SET_ITEM(field, "gas_index", Py_BuildValue("i", self->data[i].gas_index));
-                    DICT_SET_ITEM(field, "meas_index", Py_BuildValue("i", self->data[i].meas_index));
-                    DICT_SET_ITEM(field, "status", Py_BuildValue("i", self->data[i].status));
-                    PyList_SetItem(pydata, self->data[i].gas_index, field);
+                    PyList_SetItem(pydata, self->data[i].gas_index, bme_field_to_dict(self, &(self->data[i])));
                     self->sample_count++;
                     counter++;
                 }
@@ -810,6 +1273,145 @@ static PyObject *bme_get_data(BMEObject *self)
     return Py_BuildValue("s", "Failed to get data");
 }
 
+BME_SERIALIZED_NOARGS(bme_get_data)
+
+/* Iterator of iter_fields(): yields each valid parallel/sequential mode
+ * field as soon as the sensor reports it, instead of collecting a whole
+ * heater profile like get_data() */
+typedef struct
+{
+    PyObject_HEAD
+    BMEObject *sensor;
+    /* Fields still to yield, -1 for no limit */
+    Py_ssize_t remaining;
+    /* Valid fields of the last read not yielded yet */
+    struct bme69x_data fields[3];
+    uint8_t n_fields;
+    uint8_t pos;
+} FieldIterObject;
+
+static void
+bme_field_iter_dealloc(FieldIterObject *self)
+{
+    Py_XDECREF(self->sensor);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *bme_field_iter_next(FieldIterObject *self)
+{
+    BMEObject *sensor = self->sensor;
+    PyObject *field;
+
+    if (self->remaining == 0)
+    {
+        return NULL;
+    }
+
+    bme_lock(sensor);
+    while (self->pos >= self->n_fields)
+    {
+        sensor->del_period = bme_field_period(sensor);
+        if (sensor->del_period == 0)
+        {
+            bme_unlock(sensor);
+            PyErr_SetString(bmeError, "Sensor left parallel/sequential mode");
+            return NULL;
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+        sensor->bme.delay_us(sensor->del_period, sensor->bme.intf_ptr);
+        BUS_TXN(sensor, sensor->rslt = bme69x_get_data(sensor->op_mode, sensor->data, &(sensor->n_fields), &(sensor->bme)));
+        Py_END_ALLOW_THREADS
+        if (sensor->rslt < 0)
+        {
+            perror("bme69x_get_data");
+        }
+
+        self->n_fields = 0;
+        self->pos = 0;
+        for (uint8_t i = 0; i < sensor->n_fields; i++)
+        {
+            if (sensor->data[i].status == BME69X_VALID_DATA)
+            {
+                self->fields[self->n_fields++] = sensor->data[i];
+            }
+        }
+
+        /* Let Ctrl+C through while no valid field arrives */
+        if (self->n_fields == 0 && PyErr_CheckSignals() < 0)
+        {
+            bme_unlock(sensor);
+            return NULL;
+        }
+    }
+
+    sensor->time_ms = pi3g_timestamp_ms();
+    field = bme_field_to_dict(sensor, &(self->fields[self->pos]));
+    sensor->bme.amb_temp = self->fields[self->pos].temperature - sensor->temp_offset;
+    sensor->sample_count++;
+    self->pos++;
+    bme_unlock(sensor);
+
+    if (self->remaining > 0)
+    {
+        self->remaining--;
+    }
+    return field;
+}
+
+static PyTypeObject FieldIterType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "bme69x.FieldIterator",
+    .tp_doc = "Iterator over the fields of a BME69X in parallel or sequential mode",
+    .tp_basicsize = sizeof(FieldIterObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor)bme_field_iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc)bme_field_iter_next,
+};
+
+/* iter_fields(max_fields=-1): start the measurements like get_data() and
+ * return a FieldIterator, endless unless max_fields is given */
+static PyObject *bme_iter_fields_locked(BMEObject *self, PyObject *args)
+{
+    Py_ssize_t max_fields = -1;
+    FieldIterObject *iter;
+
+    if (!PyArg_ParseTuple(args, "|n", &max_fields))
+    {
+        return NULL;
+    }
+    if (bme_field_period(self) == 0)
+    {
+        PyErr_SetString(bmeError, "iter_fields() needs parallel or sequential mode");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    BUS_TXN(self, self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme)));
+    Py_END_ALLOW_THREADS
+    if (self->rslt != BME69X_OK)
+    {
+        perror("set_op_mode");
+    }
+
+    iter = PyObject_New(FieldIterObject, &FieldIterType);
+    if (iter == NULL)
+    {
+        return NULL;
+    }
+    Py_INCREF(self);
+    iter->sensor = self;
+    iter->remaining = (max_fields < 0) ? -1 : max_fields;
+    iter->n_fields = 0;
+    iter->pos = 0;
+
+    return (PyObject *)iter;
+}
+
+BME_SERIALIZED_VARARGS(bme_iter_fields)
+
 #ifdef BSEC
 // Internal function to process data
 static PyObject *bme_bsec_process_data(BMEObject *self, bsec_bme_settings_t *sensor_settings, uint8_t i, int64_t time_stamp)
@@ -898,7 +1500,7 @@ static PyObject *bme_bsec_process_data(BMEObject *self, bsec_bme_settings_t *sen
     PyObject *data = PyDict_New();
 }
 
-static PyObject *bme_get_digital_nose_data(BMEObject *self)
+static PyObject *bme_get_digital_nose_data_locked(BMEObject *self)
 {
     // Create Timestamp and wait until measurement has to be triggered
     int64_t time_stamp = pi3g_timestamp_ns();
@@ -907,18 +1509,23 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
     if (time_stamp >= (int64_t)self->next_call)
     {
         bsec_bme_settings_t sensor_settings;
+        int8_t conf_rslt;
+        int8_t heatr_rslt;
 
+        Py_BEGIN_ALLOW_THREADS
         self->rslt = bsec_sensor_control(self->bsec_inst, time_stamp, &sensor_settings);
         if (self->debug_mode == 1 && self->rslt != BSEC_OK)
         {
             printf("BSEC SENSOR CONTROL RSLT %d\n", self->rslt);
         }
+        pi3g_bsec_timing_result(&(self->bsec_timing), self->rslt);
+        pi3g_bsec_timing_call(&(self->bsec_timing), time_stamp, (int64_t)sensor_settings.next_call);
         self->next_call = sensor_settings.next_call;
 
         /* Select the power mode */
         /* Must be set before writing the sensor configuration */
         self->op_mode = sensor_settings.op_mode;
-        self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme));
+        BUS_TXN(self, self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme)));
         if (self->rslt != BME69X_OK)
         {
             perror("set_op_mode");
@@ -926,15 +1533,21 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
 
         /* Configure sensor */
         /* Set sensor configuration */
-        self->rslt = pi3g_set_conf(sensor_settings.humidity_oversampling, sensor_settings.pressure_oversampling, sensor_settings.pressure_oversampling, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode);
-        if (self->rslt < 0)
+        BUS_TXN(self, conf_rslt = pi3g_set_conf(sensor_settings.humidity_oversampling, sensor_settings.pressure_oversampling, sensor_settings.pressure_oversampling, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode));
+        heatr_rslt = conf_rslt;
+        if (conf_rslt >= 0)
+        {
+            BUS_TXN(self, heatr_rslt = pi3g_set_heater_conf_pm(sensor_settings.run_gas, sensor_settings.heater_temperature_profile, sensor_settings.heater_duration_profile, sensor_settings.heater_profile_len, &(self->conf), &(self->heatr_conf), &(self->bme), self->debug_mode));
+        }
+        Py_END_ALLOW_THREADS
+
+        self->rslt = heatr_rslt;
+        if (conf_rslt < 0)
         {
             PyErr_SetString(bmeError, "FAILED TO SET CONFIG");
             return NULL;
         }
-
-        self->rslt = pi3g_set_heater_conf_pm(sensor_settings.run_gas, sensor_settings.heater_temperature_profile, sensor_settings.heater_duration_profile, sensor_settings.heater_profile_len, &(self->conf), &(self->heatr_conf), &(self->bme), self->debug_mode);
-        if (self->rslt < 0)
+        if (heatr_rslt < 0)
         {
             PyErr_SetString(bmeError, "FAILED TO SET HEATER CONFIG");
             return NULL;
@@ -957,11 +1570,13 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
                 uint8_t counter = 0;
                 while (counter < self->heatr_conf.profile_len)
                 {
+                    Py_BEGIN_ALLOW_THREADS
                     self->del_period = bme69x_get_meas_dur(BME69X_PARALLEL_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.shared_heatr_dur * 1000);
                     self->bme.delay_us(self->del_period, self->bme.intf_ptr);
                     self->time_ms = pi3g_timestamp_ms();
 
-                    self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme));
+                    BUS_TXN(self, self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme)));
+                    Py_END_ALLOW_THREADS
                     if (self->rslt < 0)
                     {
                         perror("bme69x_get_data");
@@ -1081,7 +1696,10 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
                             bsec_output_t bsec_outputs[BSEC_NUMBER_OUTPUTS];
                             uint8_t n_output = BSEC_NUMBER_OUTPUTS;
 
+                            Py_BEGIN_ALLOW_THREADS
                             self->rslt = bsec_do_steps(self->bsec_inst, inputs, n_bsec_inputs, bsec_outputs, &n_output);
+                            Py_END_ALLOW_THREADS
+                            pi3g_bsec_timing_result(&(self->bsec_timing), self->rslt);
                             if (self->rslt == BSEC_W_DOSTEPS_GASINDEXMISS)
                             {
                                 printf("MISSED GAS INDEX \n");
@@ -1096,6 +1714,7 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
                             {
                                 // Read processed data into python Dict pydata
                                 /* Iterate through the outputs and extract the relevant ones. */
+                                pi3g_bsec_timing_sample(&(self->bsec_timing), time_stamp);
                                 self->sample_count++;
                                 PyObject *bsec_data = PyDict_New();
                                 DICT_SET_ITEM(bsec_data, "sample_nr", Py_BuildValue("i", self->sample_count));
@@ -1186,849 +1805,2714 @@ static PyObject *bme_get_digital_nose_data(BMEObject *self)
     Py_RETURN_NONE;
 }
 
-static PyObject *bme_get_bsec_data(BMEObject *self)
+BME_SERIALIZED_NOARGS(bme_get_digital_nose_data)
+
+/* First half of a get_bsec_data() cycle: ask BSEC for its settings and
+ * start the forced measurement it wants. Like the other bme_bsec_*()
+ * helpers it touches no Python objects, so it runs with the GIL released.
+ * Returns 1 if a measurement was started, with its duration in us in
+ * self->del_period, 0 if BSEC does not want one yet and -1 with *error set
+ * on failure. */
+static int bme_bsec_trigger(BMEObject *self, bsec_bme_settings_t *sensor_settings, struct pi3g_bsec_sample *sample, const char **error)
 {
     /* Call TVOC calibration function to manage baseline adaptation */
     tvoc_equivalent_calibration();
-    
+
     // Create Timestamp and wait until measurement has to be triggered
     int64_t time_stamp = pi3g_timestamp_ns();
+    sample->time_stamp = time_stamp;
+    sample->processed = 0;
+    sample->n_outputs = 0;
+
     // Check if bsec_sensor_controll needs to be called
-    if (time_stamp >= (int64_t)self->next_call)
+    if (time_stamp < (int64_t)self->next_call)
     {
-        bsec_bme_settings_t sensor_settings;
+        return 0;
+    }
 
-        self->rslt = bsec_sensor_control(self->bsec_inst, time_stamp, &sensor_settings);
-        if (self->debug_mode == 1 && self->rslt != BSEC_OK)
-        {
-            printf("BSEC SENSOR CONTROL RSLT %d\n", self->rslt);
-        }
-        self->next_call = sensor_settings.next_call;
+    self->rslt = bsec_sensor_control(self->bsec_inst, time_stamp, sensor_settings);
+    if (self->debug_mode == 1 && self->rslt != BSEC_OK)
+    {
+        printf("BSEC SENSOR CONTROL RSLT %d\n", self->rslt);
+    }
+    pi3g_bsec_timing_result(&(self->bsec_timing), self->rslt);
+    pi3g_bsec_timing_call(&(self->bsec_timing), time_stamp, (int64_t)sensor_settings->next_call);
+    self->next_call = sensor_settings->next_call;
+
+    /* Configure sensor */
+    /* Set sensor configuration */
+    BUS_TXN(self, self->rslt = pi3g_set_conf(sensor_settings->humidity_oversampling, sensor_settings->pressure_oversampling, sensor_settings->pressure_oversampling, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode));
+    if (self->rslt < 0)
+    {
+        *error = "FAILED TO SET CONFIG";
+        return -1;
+    }
 
-        /* Configure sensor */
-        /* Set sensor configuration */
-        self->rslt = pi3g_set_conf(sensor_settings.humidity_oversampling, sensor_settings.pressure_oversampling, sensor_settings.pressure_oversampling, BME69X_FILTER_OFF, BME69X_ODR_NONE, &(self->conf), &(self->bme), self->debug_mode);
-        if (self->rslt < 0)
-        {
-            PyErr_SetString(bmeError, "FAILED TO SET CONFIG");
-            return NULL;
-        }
+    BUS_TXN(self, self->rslt = pi3g_set_heater_conf_fm(sensor_settings->run_gas, sensor_settings->heater_temperature, sensor_settings->heater_duration, &(self->heatr_conf), &(self->bme), self->debug_mode));
+    if (self->rslt < 0)
+    {
+        *error = "FAILED TO SET HEATER CONFIG";
+        return -1;
+    }
+
+    // In case measurement has to be triggered
+    if (!sensor_settings->trigger_measurement || sensor_settings->op_mode == BME69X_SLEEP_MODE)
+    {
+        return 0;
+    }
+
+    /* Select the power mode */
+    /* Must be set before writing the sensor configuration */
+    self->op_mode = sensor_settings->op_mode;
+    BUS_TXN(self, self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme)));
+    if (self->rslt != BME69X_OK)
+    {
+        perror("set_op_mode");
+    }
+
+    self->del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.heatr_dur * 1000);
+
+    return 1;
+}
+
+/* Add the outputs of one field to sample. In a parallel or sequential scan
+ * BSEC reports the virtual sensors on some fields only, so outputs of the
+ * earlier fields are kept and only a newer value of the same output
+ * replaces them. */
+static void bme_bsec_merge_outputs(struct pi3g_bsec_sample *sample, const bsec_output_t *outputs, uint8_t n_outputs)
+{
+    for (uint8_t i = 0; i < n_outputs; i++)
+    {
+        uint8_t j = 0;
 
-        self->rslt = pi3g_set_heater_conf_fm(sensor_settings.run_gas, sensor_settings.heater_temperature, sensor_settings.heater_duration, &(self->heatr_conf), &(self->bme), self->debug_mode);
-        if (self->rslt < 0)
+        while (j < sample->n_outputs && sample->outputs[j].sensor_id != outputs[i].sensor_id)
         {
-            PyErr_SetString(bmeError, "FAILED TO SET HEATER CONFIG");
-            return NULL;
+            j++;
         }
-        uint8_t check_meas_index = 1;
-
-        // In case measurement has to be triggered
-        if (sensor_settings.trigger_measurement && sensor_settings.op_mode != BME69X_SLEEP_MODE)
+        if (j == sample->n_outputs)
         {
-            /* Select the power mode */
-            /* Must be set before writing the sensor configuration */
-            self->op_mode = sensor_settings.op_mode;
-            self->rslt = bme69x_set_op_mode(self->op_mode, &(self->bme));
-            if (self->rslt != BME69X_OK)
+            /* Cannot happen, BSEC has no more output ids */
+            if (sample->n_outputs == BSEC_NUMBER_OUTPUTS)
             {
-                perror("set_op_mode");
+                continue;
             }
+            sample->n_outputs++;
+        }
+        sample->outputs[j] = outputs[i];
+    }
+}
 
-            PyObject *bsec_data = PyDict_New();
-            self->del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.shared_heatr_dur * 1000);
-            self->bme.delay_us(self->del_period, self->bme.intf_ptr);
-            self->time_ms = pi3g_timestamp_ms();
+/* Second half of a get_bsec_data() cycle: read the finished measurement
+ * and run it through BSEC. Returns 1, sample->processed is set if BSEC
+ * produced outputs, or -1 with *error set on failure. */
+static int bme_bsec_harvest(BMEObject *self, const bsec_bme_settings_t *sensor_settings, struct pi3g_bsec_sample *sample, const char **error)
+{
+    int64_t time_stamp = sample->time_stamp;
+    uint8_t check_meas_index = 1;
 
-            self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme));
-            if (self->rslt < 0)
-            {
-                perror("bme69x_get_data");
-            }
+    self->time_ms = pi3g_timestamp_ms();
 
-            /* Check if rslt == BME69X_OK, report or handle if otherwise */
-            for (uint8_t i = 0; i < self->n_fields; i++)
+    BUS_TXN(self, self->rslt = bme69x_get_data(self->op_mode, self->data, &(self->n_fields), &(self->bme)));
+    if (self->rslt < 0)
+    {
+        perror("bme69x_get_data");
+    }
+
+    /* Check if rslt == BME69X_OK, report or handle if otherwise */
+    for (uint8_t i = 0; i < self->n_fields; i++)
+    {
+        if (self->data[i].status & BME69X_GASM_VALID_MSK)
+        {
+            /* Measurement index check to track the first valid sample after operation mode change */
+            if (check_meas_index)
             {
-                if (self->data[i].status & BME69X_GASM_VALID_MSK)
+                /* After changing the operation mode, Measurement index expected to be zero
+                * however with considering the data miss case as well, condition shall be checked less
+                * than last received measurement index */
+                if (self->last_meas_index == 0 || self->data[i].meas_index == 0 || self->data[i].meas_index < self->last_meas_index)
                 {
-                    /* Measurement index check to track the first valid sample after operation mode change */
-                    if (check_meas_index)
-                    {
-                        /* After changing the operation mode, Measurement index expected to be zero
-                        * however with considering the data miss case as well, condition shall be checked less
-                        * than last received measurement index */
-                        if (self->last_meas_index == 0 || self->data[i].meas_index == 0 || self->data[i].meas_index < self->last_meas_index)
-                        {
-                            check_meas_index = false;
-                        }
-                        else
-                        {
-                            continue; // Skip the invalid data samples or data from last duty cycle scan
-                        }
-                    }
+                    check_meas_index = false;
+                }
+                else
+                {
+                    continue; // Skip the invalid data samples or data from last duty cycle scan
+                }
+            }
 
-                    self->last_meas_index = self->data[i].meas_index;
+            self->last_meas_index = self->data[i].meas_index;
 
-                    // We got valid data, time to bsec_do_steps
-                    uint8_t n_bsec_inputs = 0;
-                    bsec_input_t inputs[BSEC_MAX_PHYSICAL_SENSOR];
+            // We got valid data, time to bsec_do_steps
+            uint8_t n_bsec_inputs = 0;
+            bsec_input_t inputs[BSEC_MAX_PHYSICAL_SENSOR];
 
-                    // Read the data into bsec_input_t[]
-                    if (sensor_settings.process_data)
-                    {
-                        /* Pressure to be processed by BSEC */
-                        if (sensor_settings.process_data & BSEC_PROCESS_PRESSURE)
-                        {
-                            // printf("PRESSURE %f\n", self->data[i].pressure);
-                            /* Place presssure sample into input struct */
-                            inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_PRESSURE;
-                            inputs[n_bsec_inputs].signal = self->data[i].pressure;
-                            inputs[n_bsec_inputs].time_stamp = time_stamp;
-                            n_bsec_inputs++;
-                        }
-                        /* Temperature to be processed by BSEC */
-                        if (sensor_settings.process_data & BSEC_PROCESS_TEMPERATURE)
-                        {
-                            // printf("TEMPERATURE %f\n", self->data[i].temperature);
-                            /* Place temperature sample into input struct */
-                            inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_TEMPERATURE;
+            // Read the data into bsec_input_t[]
+            if (sensor_settings->process_data)
+            {
+                /* Pressure to be processed by BSEC */
+                if (sensor_settings->process_data & BSEC_PROCESS_PRESSURE)
+                {
+                    // printf("PRESSURE %f\n", self->data[i].pressure);
+                    /* Place presssure sample into input struct */
+                    inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_PRESSURE;
+                    inputs[n_bsec_inputs].signal = self->data[i].pressure;
+                    inputs[n_bsec_inputs].time_stamp = time_stamp;
+                    n_bsec_inputs++;
+                }
+                /* Temperature to be processed by BSEC */
+                if (sensor_settings->process_data & BSEC_PROCESS_TEMPERATURE)
+                {
+                    // printf("TEMPERATURE %f\n", self->data[i].temperature);
+                    /* Place temperature sample into input struct */
+                    inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_TEMPERATURE;
 #ifdef BME69X_FLOAT_POINT_COMPENSATION
-                            inputs[n_bsec_inputs].signal = self->data[i].temperature;
+                    inputs[n_bsec_inputs].signal = self->data[i].temperature;
 #else
-                            inputs[n_bsec_inputs].signal = self->data[i].temperature / 100.0f;
+                    inputs[n_bsec_inputs].signal = self->data[i].temperature / 100.0f;
 #endif
-                            inputs[n_bsec_inputs].time_stamp = time_stamp;
-                            n_bsec_inputs++;
-
-                            /* Also add optional heatsource input which will be subtracted from the temperature reading to 
-                            * compensate for device-specific self-heating (supported in BSEC IAQ solution)*/
-                            inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_HEATSOURCE;
-                            inputs[n_bsec_inputs].signal = self->temp_offset;
-                            inputs[n_bsec_inputs].time_stamp = time_stamp;
-                            n_bsec_inputs++;
-                        }
-                        /* Humidity to be processed by BSEC */
-                        if (sensor_settings.process_data & BSEC_PROCESS_HUMIDITY)
-                        {
-                            // printf("HUMIDITY %f\n",self->data[i].humidity);
-                            /* Place humidity sample into input struct */
-                            inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_HUMIDITY;
+                    inputs[n_bsec_inputs].time_stamp = time_stamp;
+                    n_bsec_inputs++;
+
+                    /* Also add optional heatsource input which will be subtracted from the temperature reading to 
+                    * compensate for device-specific self-heating (supported in BSEC IAQ solution)*/
+                    inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_HEATSOURCE;
+                    inputs[n_bsec_inputs].signal = self->temp_offset;
+                    inputs[n_bsec_inputs].time_stamp = time_stamp;
+                    n_bsec_inputs++;
+                }
+                /* Humidity to be processed by BSEC */
+                if (sensor_settings->process_data & BSEC_PROCESS_HUMIDITY)
+                {
+                    // printf("HUMIDITY %f\n",self->data[i].humidity);
+                    /* Place humidity sample into input struct */
+                    inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_HUMIDITY;
 #ifdef BME69X_FLOAT_POINT_COMPENSATION
-                            inputs[n_bsec_inputs].signal = self->data[i].humidity;
+                    inputs[n_bsec_inputs].signal = self->data[i].humidity;
 #else
-                            inputs[n_bsec_inputs].signal = self->data[i].humidity / 1000.0f;
+                    inputs[n_bsec_inputs].signal = self->data[i].humidity / 1000.0f;
 #endif
-                            inputs[n_bsec_inputs].time_stamp = time_stamp;
-                            n_bsec_inputs++;
-                        }
-                        /* Gas to be processed by BSEC */
-                        if (sensor_settings.process_data & BSEC_PROCESS_GAS)
-                        {
-                            // printf("GAS_RESISTANCE %f\n", self->data[i].gas_resistance);
-                            /* Check whether gas_valid flag is set */
-                            if (self->data[i].status & BME69X_GASM_VALID_MSK)
-                            {
-                                /* Place sample into input struct */
-                                inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_GASRESISTOR;
-                                inputs[n_bsec_inputs].signal = self->data[i].gas_resistance;
-                                inputs[n_bsec_inputs].time_stamp = time_stamp;
-                                n_bsec_inputs++;
-                            }
-                        }
-                        /* Profile part */
-                        if (self->op_mode == BME69X_PARALLEL_MODE || self->op_mode == BME69X_SEQUENTIAL_MODE)
-                        {
-                            // printf("PROFILE_PART %d\n", self->data[i].gas_index);
-                            inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_PROFILE_PART;
-                            inputs[n_bsec_inputs].signal = self->data[i].gas_index;
-                            inputs[n_bsec_inputs].time_stamp = time_stamp;
-                            n_bsec_inputs++;
-                        }
-                    }
-                    bsec_output_t bsec_outputs[BSEC_NUMBER_OUTPUTS];
-                    uint8_t n_output = BSEC_NUMBER_OUTPUTS;
-
-                    self->rslt = bsec_do_steps(self->bsec_inst, inputs, n_bsec_inputs, bsec_outputs, &n_output);
-                    if (self->rslt != BSEC_OK)
-                    {
-                        printf("BSEC DO STEPS ERROR %d\nAT PROFILE PART %d\n", self->rslt, self->data[i].gas_index);
-                        PyErr_SetString(bmeError, "BSEC Failed to process data");
-                        return NULL;
-                    }
-                    else
+                    inputs[n_bsec_inputs].time_stamp = time_stamp;
+                    n_bsec_inputs++;
+                }
+                /* Gas to be processed by BSEC */
+                if (sensor_settings->process_data & BSEC_PROCESS_GAS)
+                {
+                    // printf("GAS_RESISTANCE %f\n", self->data[i].gas_resistance);
+                    /* Check whether gas_valid flag is set */
+                    if (self->data[i].status & BME69X_GASM_VALID_MSK)
                     {
-                        // Read processed data into python Dict pydata
-                        /* Iterate through the outputs and extract the relevant ones. */
-                        self->sample_count++;
-                        DICT_SET_ITEM(bsec_data, "sample_nr", Py_BuildValue("i", self->sample_count));
-                        DICT_SET_ITEM(bsec_data, "timestamp", Py_BuildValue("L", time_stamp));
-                        for (uint8_t index = 0; index < n_output; index++)
-                        {
-                            switch (bsec_outputs[index].sensor_id)
-                            {
-                            case BSEC_OUTPUT_STABILIZATION_STATUS:
-                                DICT_SET_ITEM(bsec_data, "stabilization_status", Py_BuildValue("i", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_RUN_IN_STATUS:
-                                DICT_SET_ITEM(bsec_data, "run_in_status", Py_BuildValue("i", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_IAQ:
-                                DICT_SET_ITEM(bsec_data, "iaq", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "iaq_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_STATIC_IAQ:
-                                DICT_SET_ITEM(bsec_data, "static_iaq", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "static_iaq_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_CO2_EQUIVALENT:
-                                DICT_SET_ITEM(bsec_data, "co2_equivalent", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "co2_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
-                                DICT_SET_ITEM(bsec_data, "breath_voc_equivalent", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "breath_voc_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_TVOC_EQUIVALENT:
-                                DICT_SET_ITEM(bsec_data, "tvoc_equivalent", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "tvoc_equivalent_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE:
-                                DICT_SET_ITEM(bsec_data, "temperature", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_RAW_PRESSURE:
-                                DICT_SET_ITEM(bsec_data, "raw_pressure", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
-                                DICT_SET_ITEM(bsec_data, "humidity", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_RAW_GAS:
-                                DICT_SET_ITEM(bsec_data, "raw_gas", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_RAW_TEMPERATURE:
-                                DICT_SET_ITEM(bsec_data, "raw_temperature", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_RAW_HUMIDITY:
-                                DICT_SET_ITEM(bsec_data, "raw_humidity", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_GAS_PERCENTAGE:
-                                DICT_SET_ITEM(bsec_data, "gas_percentage", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "gas_percentage_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_RAW_GAS_INDEX:
-                                DICT_SET_ITEM(bsec_data, "raw_gas_index", Py_BuildValue("d", bsec_outputs[index].signal));
-                                break;
-                            case BSEC_OUTPUT_GAS_ESTIMATE_1:
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_1", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_1_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_GAS_ESTIMATE_2:
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_2", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_2_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_GAS_ESTIMATE_3:
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_3", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_3_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            case BSEC_OUTPUT_GAS_ESTIMATE_4:
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_4", Py_BuildValue("d", bsec_outputs[index].signal));
-                                DICT_SET_ITEM(bsec_data, "gas_estimate_4_accuracy", Py_BuildValue("i", bsec_outputs[index].accuracy));
-                                break;
-                            default:
-                                continue;
-                            }
-                        }
+                        /* Place sample into input struct */
+                        inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_GASRESISTOR;
+                        inputs[n_bsec_inputs].signal = self->data[i].gas_resistance;
+                        inputs[n_bsec_inputs].time_stamp = time_stamp;
+                        n_bsec_inputs++;
                     }
                 }
+                /* Profile part */
+                if (self->op_mode == BME69X_PARALLEL_MODE || self->op_mode == BME69X_SEQUENTIAL_MODE)
+                {
+                    // printf("PROFILE_PART %d\n", self->data[i].gas_index);
+                    inputs[n_bsec_inputs].sensor_id = BSEC_INPUT_PROFILE_PART;
+                    inputs[n_bsec_inputs].signal = self->data[i].gas_index;
+                    inputs[n_bsec_inputs].time_stamp = time_stamp;
+                    n_bsec_inputs++;
+                }
+            }
+            bsec_output_t outputs[BSEC_NUMBER_OUTPUTS];
+            uint8_t n_outputs = BSEC_NUMBER_OUTPUTS;
+
+            self->rslt = bsec_do_steps(self->bsec_inst, inputs, n_bsec_inputs, outputs, &n_outputs);
+            pi3g_bsec_timing_result(&(self->bsec_timing), self->rslt);
+            if (self->rslt < BSEC_OK)
+            {
+                printf("BSEC DO STEPS ERROR %d\nAT PROFILE PART %d\n", self->rslt, self->data[i].gas_index);
+                *error = "BSEC Failed to process data";
+                return -1;
+            }
+            /* Warnings are counted above, the outputs still hold */
+            if (self->debug_mode == 1 && self->rslt != BSEC_OK)
+            {
+                printf("BSEC DO STEPS WARNING %d\n", self->rslt);
             }
-            // self->bme.amb_temp = self->data[0].temperature - self->temp_offset;
-            return bsec_data;
+            bme_bsec_merge_outputs(sample, outputs, n_outputs);
+            pi3g_bsec_timing_sample(&(self->bsec_timing), time_stamp);
+            self->sample_count++;
+            sample->sample_nr = self->sample_count;
+            sample->processed = 1;
         }
     }
-    Py_RETURN_NONE;
-    return NULL;
-}
-
-static PyObject *bme_get_bsec_version(BMEObject *self)
-{
-    bsec_version_t version;
-    bsec_get_version(self->bsec_inst, &version);
-    char buffer[13];
-    snprintf(buffer, 13, "%d.%d.%d.%d", version.major, version.minor, version.major_bugfix, version.minor_bugfix);
-    return Py_BuildValue("s", buffer);
+    return 1;
 }
 
-static PyObject *bme_get_bsec_conf(BMEObject *self)
+/* Raise unless the BSEC cycles are free to be run from Python: no
+ * background acquisition and no trigger() waiting for its collect() */
+static int bme_bsec_check_idle(BMEObject *self)
 {
-    uint8_t conf_set_id = 0;
-    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    uint32_t n_serialized_settings = 0;
-
-    self->rslt = bsec_get_configuration(&(self->bme),conf_set_id, serialized_settings, n_serialized_settings_max, work_buffer, n_work_buffer, &n_serialized_settings);
-
-    if (self->rslt != BSEC_OK)
+    if (self->acq_running)
     {
-        PyErr_SetString(bmeError, "Failed to read BSEC conf");
-        return NULL;
+        PyErr_SetString(bmeError, "Acquisition is running, use read_samples()");
+        return -1;
     }
-
-    // Create and populate Python List Object
-    PyObject *conf_list = PyList_New(BSEC_MAX_PROPERTY_BLOB_SIZE);
-    for (uint32_t i = 0; i < BSEC_MAX_PROPERTY_BLOB_SIZE; i++)
+    if (self->split_pending)
     {
-        PyList_SetItem(conf_list, i, Py_BuildValue("i", serialized_settings[i]));
+        PyErr_SetString(bmeError, "A triggered measurement is pending, call collect() first");
+        return -1;
     }
-
-    return conf_list;
+    return 0;
 }
 
-static PyObject *bme_set_bsec_conf(BMEObject *self, PyObject *args)
+/* Sensor and BSEC part of get_bsec_data(). Returns 1 if a measurement was
+ * taken (sample->processed is set if BSEC produced outputs for it), 0 if
+ * BSEC does not want one yet and -1 with *error set on failure. In
+ * low-power mode it sleeps past the end of the measurement, so the first
+ * status read normally finds the data and no polls are needed. */
+static int bme_bsec_cycle(BMEObject *self, uint8_t low_power, struct pi3g_bsec_sample *sample, const char **error)
 {
-    PyObject *conf_list_obj;
+    bsec_bme_settings_t sensor_settings;
+    int ret;
 
-    printf("[set_bsec_conf] Called\n");
-    if (!PyArg_ParseTuple(args, "O", &conf_list_obj))
+    ret = bme_bsec_trigger(self, &sensor_settings, sample, error);
+    if (ret <= 0)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
-        return (PyObject *)NULL;
+        return ret;
     }
 
-    if (!PyList_Check(conf_list_obj))
+    /* Sleep to just before the end of the measurement, then poll for it */
+    if (bme69x_wait_data(self->del_period + (low_power ? 2 * BME69X_POLL_MARGIN : 0), &(self->bme)) < 0)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
-        return (PyObject *)NULL;
+        perror("bme69x_wait_data");
     }
 
-    uint32_t conf_size = PyList_Size(conf_list_obj);
-    if (conf_size != BSEC_MAX_PROPERTY_BLOB_SIZE)
+    return bme_bsec_harvest(self, &sensor_settings, sample, error);
+}
+
+/* BSEC outputs of a get_bsec_data() cycle as dict, empty if BSEC did not
+ * produce any */
+static PyObject *bme_bsec_sample_to_dict(const struct pi3g_bsec_sample *sample)
+{
+    PyObject *bsec_data = PyDict_New();
+    if (bsec_data == NULL || !sample->processed)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
-        return (PyObject *)NULL;
+        return bsec_data;
     }
 
-    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
-
-    PyObject *val;
-    for (uint32_t i = 0; i < BSEC_MAX_PROPERTY_BLOB_SIZE; i++)
+    DICT_SET_ITEM(bsec_data, "sample_nr", Py_BuildValue("i", sample->sample_nr));
+    DICT_SET_ITEM(bsec_data, "timestamp", Py_BuildValue("L", sample->time_stamp));
+    for (uint8_t index = 0; index < sample->n_outputs; index++)
     {
-        val = PyList_GetItem(conf_list_obj, i);
-        if (!val)
+        switch (sample->outputs[index].sensor_id)
         {
-            PyErr_SetString(bmeError, "Failed to get config list item");
-            return (PyObject *)NULL;
-        }
-        serialized_settings[i] = (uint8_t)PyLong_AsLong(val);
-        if (PyErr_Occurred())
-        {
-            PyErr_SetString(bmeError, "Config list items must be integers");
-            return (PyObject *)NULL;
+        case BSEC_OUTPUT_STABILIZATION_STATUS:
+            DICT_SET_ITEM(bsec_data, "stabilization_status", Py_BuildValue("i", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_RUN_IN_STATUS:
+            DICT_SET_ITEM(bsec_data, "run_in_status", Py_BuildValue("i", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_IAQ:
+            DICT_SET_ITEM(bsec_data, "iaq", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "iaq_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_STATIC_IAQ:
+            DICT_SET_ITEM(bsec_data, "static_iaq", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "static_iaq_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_CO2_EQUIVALENT:
+            DICT_SET_ITEM(bsec_data, "co2_equivalent", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "co2_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
+            DICT_SET_ITEM(bsec_data, "breath_voc_equivalent", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "breath_voc_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_TVOC_EQUIVALENT:
+            DICT_SET_ITEM(bsec_data, "tvoc_equivalent", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "tvoc_equivalent_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE:
+            DICT_SET_ITEM(bsec_data, "temperature", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_RAW_PRESSURE:
+            DICT_SET_ITEM(bsec_data, "raw_pressure", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
+            DICT_SET_ITEM(bsec_data, "humidity", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_RAW_GAS:
+            DICT_SET_ITEM(bsec_data, "raw_gas", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_RAW_TEMPERATURE:
+            DICT_SET_ITEM(bsec_data, "raw_temperature", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_RAW_HUMIDITY:
+            DICT_SET_ITEM(bsec_data, "raw_humidity", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_GAS_PERCENTAGE:
+            DICT_SET_ITEM(bsec_data, "gas_percentage", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "gas_percentage_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_RAW_GAS_INDEX:
+            DICT_SET_ITEM(bsec_data, "raw_gas_index", Py_BuildValue("d", sample->outputs[index].signal));
+            break;
+        case BSEC_OUTPUT_GAS_ESTIMATE_1:
+            DICT_SET_ITEM(bsec_data, "gas_estimate_1", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "gas_estimate_1_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_GAS_ESTIMATE_2:
+            DICT_SET_ITEM(bsec_data, "gas_estimate_2", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "gas_estimate_2_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_GAS_ESTIMATE_3:
+            DICT_SET_ITEM(bsec_data, "gas_estimate_3", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "gas_estimate_3_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        case BSEC_OUTPUT_GAS_ESTIMATE_4:
+            DICT_SET_ITEM(bsec_data, "gas_estimate_4", Py_BuildValue("d", sample->outputs[index].signal));
+            DICT_SET_ITEM(bsec_data, "gas_estimate_4_accuracy", Py_BuildValue("i", sample->outputs[index].accuracy));
+            break;
+        default:
+            continue;
         }
     }
+    return bsec_data;
+}
 
-    // Apply the configuration - pass actual config size, not max size
-    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
-    printf("[set_bsec_conf] bsec_set_configuration(conf_size=%u) returned %d\n", conf_size, (int)self->rslt);
-    if (self->rslt != BSEC_OK)
+static PyObject *bme_get_bsec_data_locked(BMEObject *self)
+{
+    struct pi3g_bsec_sample sample;
+    const char *error = NULL;
+    int ret;
+
+    if (bme_bsec_check_idle(self) < 0)
     {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Could not set BSEC config (bsec_rslt=%d)", (int)self->rslt);
-        PyErr_SetString(bmeError, msg);
-        return (PyObject *)NULL;
+        return NULL;
     }
 
-    if (self->debug_mode == 1)
+    Py_BEGIN_ALLOW_THREADS
+    ret = bme_bsec_cycle(self, 0, &sample, &error);
+    Py_END_ALLOW_THREADS
+
+    if (ret < 0)
     {
-        printf("SET BSEC CONF RLST %d\n", self->rslt);
+        PyErr_SetString(bmeError, error);
+        return NULL;
     }
-
-    return Py_BuildValue("i", self->rslt);
+    if (ret == 0)
+    {
+        Py_RETURN_NONE;
+    }
+    return bme_bsec_sample_to_dict(&sample);
 }
 
-static PyObject *bme_get_bsec_state(BMEObject *self)
-{
-    // state set id = 0 to retrieve all states
-    uint8_t state_set_id = 0;
-    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
-    uint32_t n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
-    uint8_t work_buffer_state[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_work_buffer_state = BSEC_MAX_STATE_BLOB_SIZE;
+BME_SERIALIZED_NOARGS(bme_get_bsec_data)
 
-    // Get BSEC state and read it into serialized state
-    self->rslt = bsec_get_state(&(self->bme), state_set_id, serialized_state, n_serialized_state_max, work_buffer_state, n_work_buffer_state, &n_serialized_state);
+/* First half of get_bsec_data(): start the measurement BSEC asks for and
+ * return when its data will be ready, in ns on the clock of next_call, or
+ * None if BSEC does not want a measurement yet */
+static PyObject *bme_trigger_locked(BMEObject *self)
+{
+    const char *error = NULL;
+    int ret;
 
-    if (self->rslt != BSEC_OK)
+    if (bme_bsec_check_idle(self) < 0)
     {
-        PyErr_SetString(bmeError, "Failed to read BSEC state");
-        return (PyObject *)NULL;
+        return NULL;
     }
 
-    // Create and populate Python List Object
-    PyObject *state_list = PyList_New(BSEC_MAX_STATE_BLOB_SIZE);
-    for (uint32_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+    Py_BEGIN_ALLOW_THREADS
+    ret = bme_bsec_trigger(self, &(self->split_settings), &(self->split_sample), &error);
+    Py_END_ALLOW_THREADS
+
+    if (ret < 0)
     {
-        PyList_SetItem(state_list, i, Py_BuildValue("i", serialized_state[i]));
+        PyErr_SetString(bmeError, error);
+        return NULL;
+    }
+    if (ret == 0)
+    {
+        Py_RETURN_NONE;
     }
+    self->split_pending = 1;
+    self->split_ready_ns = pi3g_timestamp_ns() + (int64_t)self->del_period * 1000;
 
-    return state_list;
+    return Py_BuildValue("L", self->split_ready_ns);
 }
 
-static PyObject *bme_set_bsec_state(BMEObject *self, PyObject *args)
+BME_SERIALIZED_NOARGS(bme_trigger)
+
+/* Second half of get_bsec_data(): wait for the measurement of trigger()
+ * if it is not done yet, read it and run BSEC. Returns the same dict as
+ * get_bsec_data(). */
+static PyObject *bme_collect_locked(BMEObject *self)
 {
-    PyObject *state_list_obj;
+    const char *error = NULL;
+    int64_t left_ns;
+    int ret;
 
-    if (!PyArg_ParseTuple(args, "O", &state_list_obj))
+    if (!self->split_pending)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
-        return (PyObject *)NULL;
+        PyErr_SetString(bmeError, "No triggered measurement, call trigger() first");
+        return NULL;
     }
 
-    if (!PyList_Check(state_list_obj))
+    Py_BEGIN_ALLOW_THREADS
+    left_ns = self->split_ready_ns - pi3g_timestamp_ns();
+    if (bme69x_wait_data(left_ns > 0 ? (uint32_t)(left_ns / 1000) : 0, &(self->bme)) < 0)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
-        return (PyObject *)NULL;
+        perror("bme69x_wait_data");
     }
+    ret = bme_bsec_harvest(self, &(self->split_settings), &(self->split_sample), &error);
+    Py_END_ALLOW_THREADS
+    self->split_pending = 0;
 
-    uint32_t state_size = PyList_Size(state_list_obj);
-    if (state_size > BSEC_MAX_STATE_BLOB_SIZE)
+    if (ret < 0)
     {
-        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
-        return (PyObject *)NULL;
+        PyErr_SetString(bmeError, error);
+        return NULL;
     }
+    return bme_bsec_sample_to_dict(&(self->split_sample));
+}
 
-    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
-    uint8_t work_buffer[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_STATE_BLOB_SIZE;
+BME_SERIALIZED_NOARGS(bme_collect)
 
-    PyObject *val;
-    for (uint32_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+/* get_bsec_data() without the polling loop: sleep until BSEC's next_call
+ * and return the data of the next measurement BSEC asks for. The object
+ * lock is only held for the measurement, not for the sleep. */
+static PyObject *bme_wait_for_next_call(BMEObject *self, PyObject *Py_UNUSED(ignored))
+{
+    struct pi3g_bsec_sample sample;
+    const char *error = NULL;
+    int64_t next_call;
+    int ret;
+
+    if (bme_bsec_check_idle(self) < 0)
     {
-        val = PyList_GetItem(state_list_obj, i);
-        serialized_state[i] = (uint8_t)PyLong_AsLong(val);
+        return NULL;
     }
 
-    // Apply the configuration
-    self->rslt = bsec_set_state(&(self->bme), serialized_state, n_serialized_state_max, work_buffer, n_work_buffer);
-
-    if (self->debug_mode == 1)
+    for (;;)
     {
-        printf("SET BSEC STATE RSLT %d\n", self->rslt);
-    }
-    return Py_BuildValue("i", self->rslt);
-}
+        bme_lock(self);
+        next_call = (int64_t)self->next_call;
+        bme_unlock(self);
+
+        Py_BEGIN_ALLOW_THREADS
+        ret = pi3g_sleep_until_ns(next_call);
+        Py_END_ALLOW_THREADS
+        if (ret != 0)
+        {
+            /* Interrupted, let Python handle e.g. Ctrl+C before sleeping on */
+            if (PyErr_CheckSignals() < 0)
+            {
+                return NULL;
+            }
+            continue;
+        }
 
-// Load BSEC config from an arbitrary file path
-// Python: load_bsec_conf_from_file(path: str) -> None or raises bme69x.error
-static PyObject *bme_load_bsec_conf_from_file(BMEObject *self, PyObject *args)
+        /* start_acquisition() or trigger() may have run while we slept */
+        bme_lock(self);
+        if (bme_bsec_check_idle(self) < 0)
+        {
+            bme_unlock(self);
+            return NULL;
+        }
+        Py_BEGIN_ALLOW_THREADS
+        ret = bme_bsec_cycle(self, 0, &sample, &error);
+        Py_END_ALLOW_THREADS
+        bme_unlock(self);
+
+        if (ret < 0)
+        {
+            PyErr_SetString(bmeError, error);
+            return NULL;
+        }
+        if (ret > 0)
+        {
+            return bme_bsec_sample_to_dict(&sample);
+        }
+    }
+}
+
+static int bme_rt_parse(PyObject *args, PyObject *kwds, struct bme_rt_opts *opts)
 {
-    const char *path = NULL;
-    if (!PyArg_ParseTuple(args, "s", &path))
+    static char *kwlist[] = {"rt_priority", "cpu", "lock_memory", "spin_us", "low_power", NULL};
+    int lock_memory = 0;
+    int low_power = 0;
+
+    opts->priority = 0;
+    opts->cpu = -1;
+    opts->spin_us = -1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iipip", kwlist, &(opts->priority), &(opts->cpu), &lock_memory, &(opts->spin_us), &low_power))
     {
-        PyErr_SetString(bmeError, "Argument must be a file path (str)");
-        return NULL;
+        return -1;
     }
+    opts->lock_memory = (uint8_t)lock_memory;
+    opts->low_power = (uint8_t)low_power;
 
-    FILE *fp = fopen(path, "rb");
-    if (!fp)
+    /* Timer slack does not apply to real-time threads */
+    if (opts->low_power && opts->priority > 0)
     {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Config file not found: %s", path);
-        PyErr_SetString(bmeError, msg);
-        return NULL;
+        PyErr_SetString(bmeError, "low_power cannot be combined with rt_priority");
+        return -1;
     }
 
-    uint8_t serialized_settings_raw[BSEC_MAX_PROPERTY_BLOB_SIZE + 4];
-    size_t n_read = fread(serialized_settings_raw, 1, BSEC_MAX_PROPERTY_BLOB_SIZE + 4, fp);
-    fclose(fp);
+    return 0;
+}
 
-    if (n_read == 0)
+/* Start an acquisition thread with the real-time options applied, raises
+ * bmeError or OSError on failure */
+static int bme_rt_thread_create(pthread_t *thread, const struct bme_rt_opts *opts, void *(*start_routine)(void *), void *arg)
+{
+    pthread_attr_t attr;
+    int ret;
+
+    if (opts->lock_memory && (ret = pi3g_rt_lock_memory()) != 0)
     {
-        PyErr_SetString(bmeError, "Failed to read config file");
-        return NULL;
+        errno = ret;
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
     }
 
-    uint8_t *serialized_settings = serialized_settings_raw;
-    size_t conf_size = n_read;
+    pthread_attr_init(&attr);
+    ret = pi3g_rt_thread_attr(&attr, opts->priority, opts->cpu);
+    if (ret == 0)
+    {
+        ret = pthread_create(thread, &attr, start_routine, arg);
+    }
+    pthread_attr_destroy(&attr);
+    if (ret != 0)
+    {
+        PyErr_Format(bmeError, "Failed to start acquisition thread: %s", strerror(ret));
+        return -1;
+    }
+    return 0;
+}
 
-    if (n_read > BSEC_MAX_PROPERTY_BLOB_SIZE)
+/* Spin margin of an acquisition thread, run on the thread itself so the
+ * calibration sees its real-time policy */
+static uint32_t bme_rt_spin_ns(const struct bme_rt_opts *opts)
+{
+    if (opts->spin_us >= 0)
     {
-        uint32_t header_size = (uint32_t)serialized_settings_raw[0] |
-                               ((uint32_t)serialized_settings_raw[1] << 8) |
-                               ((uint32_t)serialized_settings_raw[2] << 16) |
-                               ((uint32_t)serialized_settings_raw[3] << 24);
-        if (header_size == BSEC_MAX_PROPERTY_BLOB_SIZE && n_read == BSEC_MAX_PROPERTY_BLOB_SIZE + 4)
+        return (uint32_t)opts->spin_us * 1000;
+    }
+    return (opts->priority > 0 && !opts->low_power) ? pi3g_calibrate_spin_ns() : 0;
+}
+
+/* Wait on cond until deadline_ns or until *stop is set. With a spin margin
+ * the sleep ends spin_ns early and the rest is spun. In low-power mode the
+ * kernel may instead wake us up to a 16th of the wait late, so it can
+ * serve other timers in the same wake-up; the default slack is restored
+ * for the measurement. On the virtual clock the sleep returns at once with
+ * the clock moved on. The wake-up error is added to *wake if the deadline
+ * was still ahead. Returns *stop. */
+static uint8_t bme_rt_wait(pthread_mutex_t *mutex, pthread_cond_t *cond, const uint8_t *stop, int64_t deadline_ns, uint32_t spin_ns, uint8_t low_power, struct pi3g_wake_stats *wake)
+{
+    int64_t sleep_ns = deadline_ns - spin_ns;
+    int64_t left_ns = deadline_ns - pi3g_timestamp_ns();
+    uint8_t waited = left_ns > 0;
+    uint8_t stopped;
+    struct timespec ts;
+    int64_t now;
+
+    if (low_power && waited)
+    {
+        int64_t slack_ns = left_ns >> PI3G_LP_SLACK_SHIFT;
+
+        (void)pi3g_set_timer_slack_ns((uint64_t)((slack_ns > PI3G_LP_SLACK_MAX_NS) ? PI3G_LP_SLACK_MAX_NS : slack_ns));
+    }
+
+    if (pi3g_clock_is_virtual())
+    {
+        (void)pi3g_sleep_until_ns(sleep_ns);
+    }
+
+    ts.tv_sec = (sleep_ns > 0) ? sleep_ns / 1000000000 : 0;
+    ts.tv_nsec = (sleep_ns > 0) ? sleep_ns % 1000000000 : 0;
+    pthread_mutex_lock(mutex);
+    while (!*stop && pi3g_timestamp_ns() < sleep_ns)
+    {
+        pthread_cond_timedwait(cond, mutex, &ts);
+    }
+    stopped = *stop;
+    pthread_mutex_unlock(mutex);
+    if (low_power && waited)
+    {
+        (void)pi3g_set_timer_slack_ns(0);
+    }
+    if (stopped)
+    {
+        return 1;
+    }
+
+    now = (spin_ns > 0) ? pi3g_spin_until_ns(deadline_ns) : pi3g_timestamp_ns();
+    pthread_mutex_lock(mutex);
+    if (waited)
+    {
+        pi3g_wake_stats_add(wake, now - deadline_ns);
+    }
+    pi3g_wake_stats_update(wake);
+    pthread_mutex_unlock(mutex);
+    return 0;
+}
+
+/* Add the wake-up statistics of an acquisition thread to dict, in us */
+static void bme_wake_stats_to_dict(PyObject *dict, const struct pi3g_wake_stats *wake, uint32_t spin_ns)
+{
+    DICT_SET_ITEM(dict, "spin_us", Py_BuildValue("d", spin_ns / 1000.0));
+    DICT_SET_ITEM(dict, "wakeups", Py_BuildValue("K", (unsigned long long)wake->wakeups));
+    DICT_SET_ITEM(dict, "wake_error_mean_us", Py_BuildValue("d", wake->wakeups ? (double)wake->err_sum_ns / wake->wakeups / 1000.0 : 0.0));
+    DICT_SET_ITEM(dict, "wake_error_max_us", Py_BuildValue("d", wake->err_max_ns / 1000.0));
+    DICT_SET_ITEM(dict, "thread_wakeups", Py_BuildValue("K", (unsigned long long)wake->thread_wakeups));
+    DICT_SET_ITEM(dict, "wakeups_per_hour", Py_BuildValue("d", wake->last_ns > wake->start_ns ? wake->thread_wakeups * 3600e9 / (double)(wake->last_ns - wake->start_ns) : 0.0));
+    DICT_SET_ITEM(dict, "wake_error_hist", bme_hist_to_list(wake->err_hist));
+}
+
+/* Acquisition thread: runs the get_bsec_data() cycle at BSEC's next_call
+ * and queues the processed samples in acq_ring. Never touches Python. */
+static void *bme_acq_main(void *arg)
+{
+    BMEObject *self = (BMEObject *)arg;
+    struct pi3g_bsec_sample sample;
+    const char *error;
+    uint32_t spin_ns = bme_rt_spin_ns(&(self->acq_rt));
+    int64_t next_call;
+    int ret;
+
+    pthread_mutex_lock(&(self->acq_mutex));
+    self->acq_spin_ns = spin_ns;
+    pi3g_wake_stats_start(&(self->acq_wake));
+    pthread_mutex_unlock(&(self->acq_mutex));
+    pthread_mutex_lock(&(self->lock));
+    self->intf.spin_ns = spin_ns;
+    pthread_mutex_unlock(&(self->lock));
+
+    for (;;)
+    {
+        pthread_mutex_lock(&(self->lock));
+        next_call = (int64_t)self->next_call;
+        pthread_mutex_unlock(&(self->lock));
+
+        /* Sleep until next_call, stop_acquisition() wakes us up early */
+        if (bme_rt_wait(&(self->acq_mutex), &(self->acq_cond), &(self->acq_stop), next_call, spin_ns, self->acq_rt.low_power, &(self->acq_wake)))
         {
-            serialized_settings = serialized_settings_raw + 4;
-            conf_size = BSEC_MAX_PROPERTY_BLOB_SIZE;
+            break;
+        }
+
+        error = NULL;
+        pthread_mutex_lock(&(self->lock));
+        ret = bme_bsec_cycle(self, self->acq_rt.low_power, &sample, &error);
+        pthread_mutex_unlock(&(self->lock));
+
+        if (ret < 0)
+        {
+            atomic_fetch_add_explicit(&(self->acq_errors), 1, memory_order_relaxed);
+            pthread_mutex_lock(&(self->acq_mutex));
+            self->acq_error = error;
+            pthread_mutex_unlock(&(self->acq_mutex));
+        }
+        else if (ret > 0 && sample.processed)
+        {
+            pi3g_sample_ring_push(self->acq_ring, &sample);
         }
     }
 
-    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    pthread_mutex_lock(&(self->lock));
+    self->intf.spin_ns = 0;
+    pthread_mutex_unlock(&(self->lock));
+    return NULL;
+}
 
-    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
-    if (self->rslt != BSEC_OK)
+/* Allocate the sample ring on first use. It outlives the acquisition so
+ * the last samples can still be read, and keeps its counters across
+ * restarts. */
+static int bme_acq_ring_alloc(BMEObject *self)
+{
+    if (self->acq_ring == NULL)
+    {
+        self->acq_ring = malloc(sizeof(struct pi3g_sample_ring));
+        if (self->acq_ring == NULL)
+        {
+            PyErr_NoMemory();
+            return -1;
+        }
+        if (pi3g_sample_ring_init(self->acq_ring) < 0)
+        {
+            PyErr_SetFromErrno(PyExc_OSError);
+            free(self->acq_ring);
+            self->acq_ring = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static PyObject *bme_start_acquisition(BMEObject *self, PyObject *args, PyObject *kwds)
+{
+    struct bme_rt_opts rt;
+
+    if (bme_rt_parse(args, kwds, &rt) < 0)
+    {
+        return NULL;
+    }
+    if (self->acq_running)
+    {
+        PyErr_SetString(bmeError, "Acquisition is already running");
+        return NULL;
+    }
+    if (bme_bsec_check_idle(self) < 0 || bme_acq_ring_alloc(self) < 0)
+    {
+        return NULL;
+    }
+
+    /* The running thread reads acq_rt, so it only changes from here on */
+    self->acq_rt = rt;
+    self->acq_stop = 0;
+    self->acq_error = NULL;
+    memset(&(self->acq_wake), 0, sizeof(self->acq_wake));
+    if (bme_rt_thread_create(&(self->acq_thread), &(self->acq_rt), bme_acq_main, self) < 0)
     {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Failed to apply config from file (bsec_rslt=%d)", (int)self->rslt);
-        PyErr_SetString(bmeError, msg);
         return NULL;
     }
+    self->acq_running = BME_ACQ_THREAD;
 
     Py_RETURN_NONE;
 }
 
-/* Load BSEC config from sensor-specific file */
-static PyObject *bme_load_bsec_conf(BMEObject *self)
+static PyObject *bme_stop_acquisition(BMEObject *self, PyObject *Py_UNUSED(ignored))
 {
-    char conf_path[256];
-    get_config_filename(self->sensor_id, conf_path, sizeof(conf_path));
-    
-    FILE *fp = fopen(conf_path, "rb");
-    if (!fp)
+    if (self->acq_running == BME_ACQ_SCHEDULER)
     {
-        if (self->debug_mode == 1)
-            printf("Config file not found: %s (this is OK for first run)\n", conf_path);
-        Py_RETURN_NONE;
+        PyErr_SetString(bmeError, "Sensor is run by a Scheduler, call its stop()");
+        return NULL;
     }
-    
-    uint8_t serialized_settings_raw[BSEC_MAX_PROPERTY_BLOB_SIZE + 4];
-    size_t n_read = fread(serialized_settings_raw, 1, BSEC_MAX_PROPERTY_BLOB_SIZE + 4, fp);
-    fclose(fp);
-    
-    if (n_read == 0)
+    bme_acq_join(self);
+    if (bme_waiters_fail(self, "Acquisition was stopped") < 0)
     {
-        PyErr_SetString(bmeError, "Failed to read config file");
         return NULL;
     }
-    
-    printf("[load_bsec_conf] Read %zu bytes from %s\n", n_read, conf_path);
-    
-    // Binary .config files from BSEC have a 4-byte header (size field in little-endian)
-    // Strip the header if present (file size > 2005 bytes for IAQ_Sel variant)
-    uint8_t *serialized_settings = serialized_settings_raw;
-    size_t conf_size = n_read;
-    
-    if (n_read > BSEC_MAX_PROPERTY_BLOB_SIZE)
+    Py_RETURN_NONE;
+}
+
+/* Drain up to max_n queued samples, all of them by default, as list of
+ * get_bsec_data() dicts oldest first */
+static PyObject *bme_read_samples(BMEObject *self, PyObject *args)
+{
+    struct pi3g_bsec_sample samples[16];
+    Py_ssize_t max_n = -1;
+    PyObject *list;
+    PyObject *item;
+    size_t want;
+    size_t n;
+
+    if (!PyArg_ParseTuple(args, "|n", &max_n))
     {
-        // Has 4-byte header - strip it
-        uint32_t header_size = (uint32_t)serialized_settings_raw[0] |
-                               ((uint32_t)serialized_settings_raw[1] << 8) |
-                               ((uint32_t)serialized_settings_raw[2] << 16) |
-                               ((uint32_t)serialized_settings_raw[3] << 24);
-        
-        if (header_size == BSEC_MAX_PROPERTY_BLOB_SIZE && n_read == BSEC_MAX_PROPERTY_BLOB_SIZE + 4)
+        return NULL;
+    }
+
+    list = PyList_New(0);
+    if (list == NULL || self->acq_ring == NULL)
+    {
+        return list;
+    }
+
+    while (max_n != 0)
+    {
+        want = sizeof(samples) / sizeof(samples[0]);
+        if (max_n > 0 && (size_t)max_n < want)
         {
-            printf("[load_bsec_conf] Detected 4-byte header (size=%u), stripping it\n", header_size);
-            serialized_settings = serialized_settings_raw + 4;
-            conf_size = BSEC_MAX_PROPERTY_BLOB_SIZE;
+            want = (size_t)max_n;
+        }
+        n = pi3g_sample_ring_pop(self->acq_ring, samples, want);
+        for (size_t i = 0; i < n; i++)
+        {
+            item = bme_bsec_sample_to_dict(&samples[i]);
+            if (item == NULL || PyList_Append(list, item) < 0)
+            {
+                Py_XDECREF(item);
+                Py_DECREF(list);
+                return NULL;
+            }
+            Py_DECREF(item);
+        }
+        if (max_n > 0)
+        {
+            max_n -= (Py_ssize_t)n;
+        }
+        if (n < want)
+        {
+            break;
         }
     }
-    
-    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    
-    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
-    printf("[load_bsec_conf] bsec_set_configuration returned %d\n", (int)self->rslt);
-    if (self->rslt != BSEC_OK)
+    return list;
+}
+
+/* Next queued sample as dict, None if there is none. Never blocks. */
+static PyObject *bme_try_read(BMEObject *self, PyObject *Py_UNUSED(ignored))
+{
+    struct pi3g_bsec_sample sample;
+
+    if (self->acq_ring == NULL || pi3g_sample_ring_pop(self->acq_ring, &sample, 1) == 0)
     {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Failed to apply loaded config to BSEC (bsec_rslt=%d)", (int)self->rslt);
-        PyErr_SetString(bmeError, msg);
-        return NULL;
+        Py_RETURN_NONE;
     }
-    
-    if (self->debug_mode == 1)
-        printf("Loaded config from: %s\n", conf_path);
-    
-    Py_RETURN_NONE;
+    return bme_bsec_sample_to_dict(&sample);
 }
 
-/* Save BSEC config to sensor-specific file */
-static PyObject *bme_save_bsec_conf(BMEObject *self)
+/* File descriptor that is readable while samples are queued, for
+ * select/poll/epoll and asyncio's add_reader(). Valid until the object is
+ * deleted, do not close it. */
+static PyObject *bme_fileno(BMEObject *self, PyObject *Py_UNUSED(ignored))
 {
-    char conf_path[256];
-    get_config_filename(self->sensor_id, conf_path, sizeof(conf_path));
-    
-    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
-    uint32_t n_serialized_settings = 0;
-    
-    self->rslt = bsec_get_configuration(self->bsec_inst, 0, serialized_settings, n_serialized_settings_max,
-                                        work_buffer, n_work_buffer, &n_serialized_settings);
-    if (self->rslt != BSEC_OK)
+    if (bme_acq_ring_alloc(self) < 0)
     {
-        PyErr_SetString(bmeError, "Failed to get BSEC configuration");
         return NULL;
     }
-    
-    FILE *fp = fopen(conf_path, "wb");
-    if (!fp)
+    return Py_BuildValue("i", self->acq_ring->efd);
+}
+
+/* Stop watching fileno() once no next_sample() future is waiting */
+static int bme_waiters_release(BMEObject *self)
+{
+    PyObject *ret;
+
+    if (self->waiter_loop == NULL || PyList_GET_SIZE(self->waiters) > 0)
     {
-        PyErr_SetString(bmeError, "Failed to open config file for writing");
-        return NULL;
+        return 0;
     }
-    
-    size_t n_written = fwrite(serialized_settings, 1, n_serialized_settings, fp);
-    fclose(fp);
-    
-    if (n_written != n_serialized_settings)
+    ret = PyObject_CallMethod(self->waiter_loop, "remove_reader", "i", self->acq_ring->efd);
+    Py_CLEAR(self->waiter_loop);
+    if (ret == NULL)
+    {
+        return -1;
+    }
+    Py_DECREF(ret);
+    return 0;
+}
+
+/* Reader callback of fileno(): hand the queued samples to the waiting
+ * futures, oldest first */
+static PyObject *bme_waiters_wake(BMEObject *self, PyObject *Py_UNUSED(ignored))
+{
+    struct pi3g_bsec_sample sample;
+
+    while (PyList_GET_SIZE(self->waiters) > 0)
+    {
+        PyObject *fut = PyList_GET_ITEM(self->waiters, 0);
+        PyObject *done = PyObject_CallMethod(fut, "done", NULL);
+        PyObject *data;
+        PyObject *ret;
+        int is_done;
+
+        if (done == NULL)
+        {
+            return NULL;
+        }
+        is_done = PyObject_IsTrue(done);
+        Py_DECREF(done);
+
+        if (!is_done)
+        {
+            if (pi3g_sample_ring_pop(self->acq_ring, &sample, 1) == 0)
+            {
+                break;
+            }
+            data = bme_bsec_sample_to_dict(&sample);
+            if (data == NULL)
+            {
+                return NULL;
+            }
+            ret = PyObject_CallMethod(fut, "set_result", "O", data);
+            Py_DECREF(data);
+            if (ret == NULL)
+            {
+                return NULL;
+            }
+            Py_DECREF(ret);
+        }
+        if (PySequence_DelItem(self->waiters, 0) < 0)
+        {
+            return NULL;
+        }
+    }
+
+    if (bme_waiters_release(self) < 0)
     {
-        PyErr_SetString(bmeError, "Failed to write all config data");
         return NULL;
     }
-    
-    if (self->debug_mode == 1)
-        printf("Saved config to: %s\n", conf_path);
-    
-    Py_RETURN_NONE;
+    Py_RETURN_NONE;
+}
+
+/* Done callback of a next_sample() future, drops it from the waiters if
+ * it was cancelled or timed out. Bound to the waiters list rather than the
+ * sensor, so a future dropped while pending leaves no cycle through an
+ * object the garbage collector cannot see. fileno() is released by the
+ * next wakeup. */
+static PyObject *bme_waiters_done(PyObject *waiters, PyObject *fut)
+{
+    Py_ssize_t n = PyList_GET_SIZE(waiters);
+
+    for (Py_ssize_t i = 0; i < n; i++)
+    {
+        if (PyList_GET_ITEM(waiters, i) == fut)
+        {
+            if (PySequence_DelItem(waiters, i) < 0)
+            {
+                return NULL;
+            }
+            break;
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+/* Fail the pending next_sample() futures with bmeError(msg) once no sample
+ * can come anymore. Samples queued before the stop are handed out first. */
+static int bme_waiters_fail(BMEObject *self, const char *msg)
+{
+    PyObject *ret;
+
+    if (self->waiter_loop == NULL)
+    {
+        return 0;
+    }
+    ret = bme_waiters_wake(self, NULL);
+    if (ret == NULL)
+    {
+        return -1;
+    }
+    Py_DECREF(ret);
+
+    while (PyList_GET_SIZE(self->waiters) > 0)
+    {
+        PyObject *fut = PyList_GET_ITEM(self->waiters, 0);
+        PyObject *done = PyObject_CallMethod(fut, "done", NULL);
+        PyObject *exc;
+        int is_done;
+
+        if (done == NULL)
+        {
+            return -1;
+        }
+        is_done = PyObject_IsTrue(done);
+        Py_DECREF(done);
+
+        if (!is_done)
+        {
+            exc = PyObject_CallFunction(bmeError, "s", msg);
+            ret = exc ? PyObject_CallMethod(fut, "set_exception", "O", exc) : NULL;
+            Py_XDECREF(exc);
+            if (ret == NULL)
+            {
+                return -1;
+            }
+            Py_DECREF(ret);
+        }
+        if (PySequence_DelItem(self->waiters, 0) < 0)
+        {
+            return -1;
+        }
+    }
+    return bme_waiters_release(self);
+}
+
+static PyMethodDef bme_waiters_wake_def = {"_wake", (PyCFunction)bme_waiters_wake, METH_NOARGS, NULL};
+static PyMethodDef bme_waiters_done_def = {"_done", (PyCFunction)bme_waiters_done, METH_O, NULL};
+
+/* Awaitable for the next queued sample. Returns a future of the running
+ * asyncio loop, resolved from the loop's reader callback on fileno() with
+ * no thread hop. Cancelling it, e.g. by asyncio.wait_for() timing out,
+ * leaves the sample queued for the next caller. */
+static PyObject *bme_next_sample(BMEObject *self, PyObject *Py_UNUSED(ignored))
+{
+    struct pi3g_bsec_sample sample;
+    PyObject *asyncio;
+    PyObject *loop;
+    PyObject *fut;
+    PyObject *cb;
+    PyObject *ret;
+
+    if (bme_acq_ring_alloc(self) < 0)
+    {
+        return NULL;
+    }
+    if (self->waiters == NULL && (self->waiters = PyList_New(0)) == NULL)
+    {
+        return NULL;
+    }
+
+    asyncio = PyImport_ImportModule("asyncio");
+    if (asyncio == NULL)
+    {
+        return NULL;
+    }
+    loop = PyObject_CallMethod(asyncio, "get_running_loop", NULL);
+    Py_DECREF(asyncio);
+    if (loop == NULL)
+    {
+        return NULL;
+    }
+    if (self->waiter_loop != NULL && self->waiter_loop != loop)
+    {
+        Py_DECREF(loop);
+        PyErr_SetString(bmeError, "next_sample() is already awaited in another event loop");
+        return NULL;
+    }
+
+    fut = PyObject_CallMethod(loop, "create_future", NULL);
+    if (fut == NULL)
+    {
+        Py_DECREF(loop);
+        return NULL;
+    }
+
+    /* Served right away if a sample is queued and nobody is ahead */
+    if (PyList_GET_SIZE(self->waiters) == 0 && pi3g_sample_ring_pop(self->acq_ring, &sample, 1) == 1)
+    {
+        PyObject *data = bme_bsec_sample_to_dict(&sample);
+
+        Py_DECREF(loop);
+        if (data == NULL)
+        {
+            Py_DECREF(fut);
+            return NULL;
+        }
+        ret = PyObject_CallMethod(fut, "set_result", "O", data);
+        Py_DECREF(data);
+        if (ret == NULL)
+        {
+            Py_DECREF(fut);
+            return NULL;
+        }
+        Py_DECREF(ret);
+        return fut;
+    }
+
+    if (!self->acq_running)
+    {
+        Py_DECREF(loop);
+        Py_DECREF(fut);
+        PyErr_SetString(bmeError, "Acquisition is not running, call start_acquisition() or start a Scheduler");
+        return NULL;
+    }
+
+    cb = PyCFunction_New(&bme_waiters_done_def, self->waiters);
+    if (cb == NULL || PyList_Append(self->waiters, fut) < 0)
+    {
+        Py_XDECREF(cb);
+        Py_DECREF(loop);
+        Py_DECREF(fut);
+        return NULL;
+    }
+    ret = PyObject_CallMethod(fut, "add_done_callback", "O", cb);
+    Py_DECREF(cb);
+    if (ret == NULL)
+    {
+        Py_DECREF(loop);
+        Py_DECREF(fut);
+        return NULL;
+    }
+    Py_DECREF(ret);
+
+    if (self->waiter_loop == NULL)
+    {
+        cb = PyCFunction_New(&bme_waiters_wake_def, (PyObject *)self);
+        ret = cb ? PyObject_CallMethod(loop, "add_reader", "iO", self->acq_ring->efd, cb) : NULL;
+        Py_XDECREF(cb);
+        if (ret == NULL)
+        {
+            Py_DECREF(loop);
+            Py_DECREF(fut);
+            return NULL;
+        }
+        Py_DECREF(ret);
+        self->waiter_loop = loop;
+    }
+    else
+    {
+        Py_DECREF(loop);
+    }
+    return fut;
+}
+
+static PyObject *bme_get_acquisition_stats(BMEObject *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *stats = PyDict_New();
+    struct pi3g_wake_stats wake;
+    const char *error;
+    uint32_t spin_ns;
+
+    if (stats == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&(self->acq_mutex));
+    error = self->acq_error;
+    wake = self->acq_wake;
+    spin_ns = self->acq_spin_ns;
+    pthread_mutex_unlock(&(self->acq_mutex));
+
+    DICT_SET_ITEM(stats, "running", PyBool_FromLong(self->acq_running != BME_ACQ_OFF));
+    DICT_SET_ITEM(stats, "queued", Py_BuildValue("n", self->acq_ring ? (Py_ssize_t)pi3g_sample_ring_count(self->acq_ring) : 0));
+    DICT_SET_ITEM(stats, "overruns", Py_BuildValue("K", self->acq_ring ? (unsigned long long)atomic_load(&(self->acq_ring->overruns)) : 0ULL));
+    DICT_SET_ITEM(stats, "dropped", Py_BuildValue("K", self->acq_ring ? (unsigned long long)atomic_load(&(self->acq_ring->dropped)) : 0ULL));
+    DICT_SET_ITEM(stats, "errors", Py_BuildValue("K", (unsigned long long)atomic_load(&(self->acq_errors))));
+    if (error)
+    {
+        DICT_SET_ITEM(stats, "last_error", Py_BuildValue("s", error));
+    }
+    else
+    {
+        Py_INCREF(Py_None);
+        DICT_SET_ITEM(stats, "last_error", Py_None);
+    }
+    bme_wake_stats_to_dict(stats, &wake, spin_ns);
+    return stats;
+}
+
+/* BSEC call timing of this sensor as dict, times in us. Lateness is how
+ * long after the previous next_call bsec_sensor_control was called, the
+ * interval error how far the time between two processed samples was off
+ * the interval BSEC asked for. */
+static PyObject *bme_get_bsec_timing_stats_locked(BMEObject *self)
+{
+    struct pi3g_bsec_timing *timing = &(self->bsec_timing);
+    uint64_t n_late = (timing->calls > 1) ? timing->calls - 1 : 0;
+    PyObject *lateness_hist = bme_hist_to_list(timing->lateness_hist);
+    PyObject *interval_hist = bme_hist_to_list(timing->interval_hist);
+    PyObject *codes = PyDict_New();
+    uint64_t warnings = 0;
+    uint64_t errors = 0;
+
+    if (lateness_hist == NULL || interval_hist == NULL || codes == NULL)
+    {
+        Py_XDECREF(lateness_hist);
+        Py_XDECREF(interval_hist);
+        Py_XDECREF(codes);
+        return NULL;
+    }
+    for (uint8_t i = 0; i < timing->n_codes; i++)
+    {
+        PyObject *code = Py_BuildValue("i", (int)timing->codes[i]);
+        PyObject *count = Py_BuildValue("K", (unsigned long long)timing->code_counts[i]);
+        PyDict_SetItem(codes, code, count);
+        Py_DECREF(code);
+        Py_DECREF(count);
+        if (timing->codes[i] > 0)
+        {
+            warnings += timing->code_counts[i];
+        }
+        else
+        {
+            errors += timing->code_counts[i];
+        }
+    }
+
+    PyObject *pydata = PyDict_New();
+    DICT_SET_ITEM(pydata, "calls", Py_BuildValue("K", (unsigned long long)timing->calls));
+    DICT_SET_ITEM(pydata, "lateness_us", Py_BuildValue("d", timing->lateness_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "mean_lateness_us", Py_BuildValue("d", n_late ? timing->lateness_sum_ns / 1000.0 / n_late : 0.0));
+    DICT_SET_ITEM(pydata, "max_lateness_us", Py_BuildValue("d", timing->lateness_max_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "lateness_hist", lateness_hist);
+    DICT_SET_ITEM(pydata, "samples", Py_BuildValue("K", (unsigned long long)timing->samples));
+    DICT_SET_ITEM(pydata, "requested_interval_us", Py_BuildValue("d", timing->period_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "mean_interval_error_us", Py_BuildValue("d", timing->intervals ? timing->interval_err_sum_ns / 1000.0 / timing->intervals : 0.0));
+    DICT_SET_ITEM(pydata, "max_interval_error_us", Py_BuildValue("d", timing->interval_err_max_ns / 1000.0));
+    DICT_SET_ITEM(pydata, "interval_error_hist", interval_hist);
+    DICT_SET_ITEM(pydata, "missed_deadlines", Py_BuildValue("K", (unsigned long long)timing->missed));
+    DICT_SET_ITEM(pydata, "warnings", Py_BuildValue("K", (unsigned long long)warnings));
+    DICT_SET_ITEM(pydata, "errors", Py_BuildValue("K", (unsigned long long)errors));
+    DICT_SET_ITEM(pydata, "codes", codes);
+    DICT_SET_ITEM(pydata, "other_codes", Py_BuildValue("K", (unsigned long long)timing->other_codes));
+    return pydata;
+}
+
+BME_SERIALIZED_NOARGS(bme_get_bsec_timing_stats)
+
+static PyObject *bme_reset_bsec_timing_stats_locked(BMEObject *self)
+{
+    pi3g_bsec_timing_reset(&(self->bsec_timing));
+    return Py_BuildValue("i", 0);
+}
+
+BME_SERIALIZED_NOARGS(bme_reset_bsec_timing_stats)
+
+static PyObject *bme_get_bsec_version_locked(BMEObject *self)
+{
+    bsec_version_t version;
+    bsec_get_version(self->bsec_inst, &version);
+    char buffer[13];
+    snprintf(buffer, 13, "%d.%d.%d.%d", version.major, version.minor, version.major_bugfix, version.minor_bugfix);
+    return Py_BuildValue("s", buffer);
+}
+
+BME_SERIALIZED_NOARGS(bme_get_bsec_version)
+
+static PyObject *bme_get_bsec_conf_locked(BMEObject *self)
+{
+    uint8_t conf_set_id = 0;
+    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    uint32_t n_serialized_settings = 0;
+
+    self->rslt = bsec_get_configuration(&(self->bme),conf_set_id, serialized_settings, n_serialized_settings_max, work_buffer, n_work_buffer, &n_serialized_settings);
+
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to read BSEC conf");
+        return NULL;
+    }
+
+    // Create and populate Python List Object
+    PyObject *conf_list = PyList_New(BSEC_MAX_PROPERTY_BLOB_SIZE);
+    for (uint32_t i = 0; i < BSEC_MAX_PROPERTY_BLOB_SIZE; i++)
+    {
+        PyList_SetItem(conf_list, i, Py_BuildValue("i", serialized_settings[i]));
+    }
+
+    return conf_list;
+}
+
+BME_SERIALIZED_NOARGS(bme_get_bsec_conf)
+
+static PyObject *bme_set_bsec_conf_locked(BMEObject *self, PyObject *args)
+{
+    PyObject *conf_list_obj;
+
+    printf("[set_bsec_conf] Called\n");
+    if (!PyArg_ParseTuple(args, "O", &conf_list_obj))
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
+        return (PyObject *)NULL;
+    }
+
+    if (!PyList_Check(conf_list_obj))
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
+        return (PyObject *)NULL;
+    }
+
+    uint32_t conf_size = PyList_Size(conf_list_obj);
+    if (conf_size != BSEC_MAX_PROPERTY_BLOB_SIZE)
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_PROPERTY_BLOB_SIZE integers");
+        return (PyObject *)NULL;
+    }
+
+    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+
+    PyObject *val;
+    for (uint32_t i = 0; i < BSEC_MAX_PROPERTY_BLOB_SIZE; i++)
+    {
+        val = PyList_GetItem(conf_list_obj, i);
+        if (!val)
+        {
+            PyErr_SetString(bmeError, "Failed to get config list item");
+            return (PyObject *)NULL;
+        }
+        serialized_settings[i] = (uint8_t)PyLong_AsLong(val);
+        if (PyErr_Occurred())
+        {
+            PyErr_SetString(bmeError, "Config list items must be integers");
+            return (PyObject *)NULL;
+        }
+    }
+
+    // Apply the configuration - pass actual config size, not max size
+    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
+    printf("[set_bsec_conf] bsec_set_configuration(conf_size=%u) returned %d\n", conf_size, (int)self->rslt);
+    if (self->rslt != BSEC_OK)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Could not set BSEC config (bsec_rslt=%d)", (int)self->rslt);
+        PyErr_SetString(bmeError, msg);
+        return (PyObject *)NULL;
+    }
+
+    if (self->debug_mode == 1)
+    {
+        printf("SET BSEC CONF RLST %d\n", self->rslt);
+    }
+
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_VARARGS(bme_set_bsec_conf)
+
+static PyObject *bme_get_bsec_state_locked(BMEObject *self)
+{
+    // state set id = 0 to retrieve all states
+    uint8_t state_set_id = 0;
+    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
+    uint32_t n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
+    uint8_t work_buffer_state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_work_buffer_state = BSEC_MAX_STATE_BLOB_SIZE;
+
+    // Get BSEC state and read it into serialized state
+    self->rslt = bsec_get_state(&(self->bme), state_set_id, serialized_state, n_serialized_state_max, work_buffer_state, n_work_buffer_state, &n_serialized_state);
+
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to read BSEC state");
+        return (PyObject *)NULL;
+    }
+
+    // Create and populate Python List Object
+    PyObject *state_list = PyList_New(BSEC_MAX_STATE_BLOB_SIZE);
+    for (uint32_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+    {
+        PyList_SetItem(state_list, i, Py_BuildValue("i", serialized_state[i]));
+    }
+
+    return state_list;
+}
+
+BME_SERIALIZED_NOARGS(bme_get_bsec_state)
+
+static PyObject *bme_set_bsec_state_locked(BMEObject *self, PyObject *args)
+{
+    PyObject *state_list_obj;
+
+    if (!PyArg_ParseTuple(args, "O", &state_list_obj))
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
+        return (PyObject *)NULL;
+    }
+
+    if (!PyList_Check(state_list_obj))
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
+        return (PyObject *)NULL;
+    }
+
+    uint32_t state_size = PyList_Size(state_list_obj);
+    if (state_size > BSEC_MAX_STATE_BLOB_SIZE)
+    {
+        PyErr_SetString(bmeError, "Argument must be list of BSEC_MAX_STATE_BLOB_SIZE (197) integers");
+        return (PyObject *)NULL;
+    }
+
+    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
+    uint8_t work_buffer[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_STATE_BLOB_SIZE;
+
+    PyObject *val;
+    for (uint32_t i = 0; i < BSEC_MAX_STATE_BLOB_SIZE; i++)
+    {
+        val = PyList_GetItem(state_list_obj, i);
+        serialized_state[i] = (uint8_t)PyLong_AsLong(val);
+    }
+
+    // Apply the configuration
+    self->rslt = bsec_set_state(&(self->bme), serialized_state, n_serialized_state_max, work_buffer, n_work_buffer);
+
+    if (self->debug_mode == 1)
+    {
+        printf("SET BSEC STATE RSLT %d\n", self->rslt);
+    }
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_VARARGS(bme_set_bsec_state)
+
+// Load BSEC config from an arbitrary file path
+// Python: load_bsec_conf_from_file(path: str) -> None or raises bme69x.error
+static PyObject *bme_load_bsec_conf_from_file_locked(BMEObject *self, PyObject *args)
+{
+    const char *path = NULL;
+    if (!PyArg_ParseTuple(args, "s", &path))
+    {
+        PyErr_SetString(bmeError, "Argument must be a file path (str)");
+        return NULL;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Config file not found: %s", path);
+        PyErr_SetString(bmeError, msg);
+        return NULL;
+    }
+
+    uint8_t serialized_settings_raw[BSEC_MAX_PROPERTY_BLOB_SIZE + 4];
+    size_t n_read = fread(serialized_settings_raw, 1, BSEC_MAX_PROPERTY_BLOB_SIZE + 4, fp);
+    fclose(fp);
+
+    if (n_read == 0)
+    {
+        PyErr_SetString(bmeError, "Failed to read config file");
+        return NULL;
+    }
+
+    uint8_t *serialized_settings = serialized_settings_raw;
+    size_t conf_size = n_read;
+
+    if (n_read > BSEC_MAX_PROPERTY_BLOB_SIZE)
+    {
+        uint32_t header_size = (uint32_t)serialized_settings_raw[0] |
+                               ((uint32_t)serialized_settings_raw[1] << 8) |
+                               ((uint32_t)serialized_settings_raw[2] << 16) |
+                               ((uint32_t)serialized_settings_raw[3] << 24);
+        if (header_size == BSEC_MAX_PROPERTY_BLOB_SIZE && n_read == BSEC_MAX_PROPERTY_BLOB_SIZE + 4)
+        {
+            serialized_settings = serialized_settings_raw + 4;
+            conf_size = BSEC_MAX_PROPERTY_BLOB_SIZE;
+        }
+    }
+
+    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+
+    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
+    if (self->rslt != BSEC_OK)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Failed to apply config from file (bsec_rslt=%d)", (int)self->rslt);
+        PyErr_SetString(bmeError, msg);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+BME_SERIALIZED_VARARGS(bme_load_bsec_conf_from_file)
+
+/* Load BSEC config from sensor-specific file */
+static PyObject *bme_load_bsec_conf_locked(BMEObject *self)
+{
+    char conf_path[256];
+    get_config_filename(self->sensor_id, conf_path, sizeof(conf_path));
+    
+    FILE *fp = fopen(conf_path, "rb");
+    if (!fp)
+    {
+        if (self->debug_mode == 1)
+            printf("Config file not found: %s (this is OK for first run)\n", conf_path);
+        Py_RETURN_NONE;
+    }
+    
+    uint8_t serialized_settings_raw[BSEC_MAX_PROPERTY_BLOB_SIZE + 4];
+    size_t n_read = fread(serialized_settings_raw, 1, BSEC_MAX_PROPERTY_BLOB_SIZE + 4, fp);
+    fclose(fp);
+    
+    if (n_read == 0)
+    {
+        PyErr_SetString(bmeError, "Failed to read config file");
+        return NULL;
+    }
+    
+    printf("[load_bsec_conf] Read %zu bytes from %s\n", n_read, conf_path);
+    
+    // Binary .config files from BSEC have a 4-byte header (size field in little-endian)
+    // Strip the header if present (file size > 2005 bytes for IAQ_Sel variant)
+    uint8_t *serialized_settings = serialized_settings_raw;
+    size_t conf_size = n_read;
+    
+    if (n_read > BSEC_MAX_PROPERTY_BLOB_SIZE)
+    {
+        // Has 4-byte header - strip it
+        uint32_t header_size = (uint32_t)serialized_settings_raw[0] |
+                               ((uint32_t)serialized_settings_raw[1] << 8) |
+                               ((uint32_t)serialized_settings_raw[2] << 16) |
+                               ((uint32_t)serialized_settings_raw[3] << 24);
+        
+        if (header_size == BSEC_MAX_PROPERTY_BLOB_SIZE && n_read == BSEC_MAX_PROPERTY_BLOB_SIZE + 4)
+        {
+            printf("[load_bsec_conf] Detected 4-byte header (size=%u), stripping it\n", header_size);
+            serialized_settings = serialized_settings_raw + 4;
+            conf_size = BSEC_MAX_PROPERTY_BLOB_SIZE;
+        }
+    }
+    
+    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    
+    self->rslt = bsec_set_configuration(self->bsec_inst, serialized_settings, conf_size, work_buffer, n_work_buffer);
+    printf("[load_bsec_conf] bsec_set_configuration returned %d\n", (int)self->rslt);
+    if (self->rslt != BSEC_OK)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Failed to apply loaded config to BSEC (bsec_rslt=%d)", (int)self->rslt);
+        PyErr_SetString(bmeError, msg);
+        return NULL;
+    }
+    
+    if (self->debug_mode == 1)
+        printf("Loaded config from: %s\n", conf_path);
+    
+    Py_RETURN_NONE;
+}
+
+BME_SERIALIZED_NOARGS(bme_load_bsec_conf)
+
+/* Save BSEC config to sensor-specific file */
+static PyObject *bme_save_bsec_conf_locked(BMEObject *self)
+{
+    char conf_path[256];
+    get_config_filename(self->sensor_id, conf_path, sizeof(conf_path));
+    
+    uint8_t serialized_settings[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_serialized_settings_max = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    uint8_t work_buffer[BSEC_MAX_PROPERTY_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_PROPERTY_BLOB_SIZE;
+    uint32_t n_serialized_settings = 0;
+    
+    self->rslt = bsec_get_configuration(self->bsec_inst, 0, serialized_settings, n_serialized_settings_max,
+                                        work_buffer, n_work_buffer, &n_serialized_settings);
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to get BSEC configuration");
+        return NULL;
+    }
+    
+    FILE *fp = fopen(conf_path, "wb");
+    if (!fp)
+    {
+        PyErr_SetString(bmeError, "Failed to open config file for writing");
+        return NULL;
+    }
+    
+    size_t n_written = fwrite(serialized_settings, 1, n_serialized_settings, fp);
+    fclose(fp);
+    
+    if (n_written != n_serialized_settings)
+    {
+        PyErr_SetString(bmeError, "Failed to write all config data");
+        return NULL;
+    }
+    
+    if (self->debug_mode == 1)
+        printf("Saved config to: %s\n", conf_path);
+    
+    Py_RETURN_NONE;
+}
+
+BME_SERIALIZED_NOARGS(bme_save_bsec_conf)
+
+/* Load BSEC state from sensor-specific file */
+static PyObject *bme_load_bsec_state_locked(BMEObject *self)
+{
+    char state_path[256];
+    get_state_filename(self->sensor_id, state_path, sizeof(state_path));
+    
+    FILE *fp = fopen(state_path, "rb");
+    if (!fp)
+    {
+        if (self->debug_mode == 1)
+            printf("State file not found: %s (this is OK for first run)\n", state_path);
+        Py_RETURN_NONE;
+    }
+    
+    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
+    size_t n_read = fread(serialized_state, 1, BSEC_MAX_STATE_BLOB_SIZE, fp);
+    fclose(fp);
+    
+    if (n_read == 0)
+    {
+        PyErr_SetString(bmeError, "Failed to read state file");
+        return NULL;
+    }
+    
+    uint8_t work_buffer[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_work_buffer = BSEC_MAX_STATE_BLOB_SIZE;
+    
+    self->rslt = bsec_set_state(self->bsec_inst, serialized_state, n_read, work_buffer, n_work_buffer);
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to apply loaded state to BSEC");
+        return NULL;
+    }
+    
+    if (self->debug_mode == 1)
+        printf("Loaded state from: %s\n", state_path);
+    
+    Py_RETURN_NONE;
+}
+
+BME_SERIALIZED_NOARGS(bme_load_bsec_state)
+
+/* Save BSEC state to sensor-specific file */
+static PyObject *bme_save_bsec_state_locked(BMEObject *self)
+{
+    char state_path[256];
+    get_state_filename(self->sensor_id, state_path, sizeof(state_path));
+    
+    uint8_t state_set_id = 0;
+    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
+    uint32_t n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
+    uint8_t work_buffer_state[BSEC_MAX_STATE_BLOB_SIZE];
+    uint32_t n_work_buffer_state = BSEC_MAX_STATE_BLOB_SIZE;
+    
+    self->rslt = bsec_get_state(self->bsec_inst, state_set_id, serialized_state, n_serialized_state_max,
+                                work_buffer_state, n_work_buffer_state, &n_serialized_state);
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to get BSEC state");
+        return NULL;
+    }
+    
+    FILE *fp = fopen(state_path, "wb");
+    if (!fp)
+    {
+        PyErr_SetString(bmeError, "Failed to open state file for writing");
+        return NULL;
+    }
+    
+    size_t n_written = fwrite(serialized_state, 1, n_serialized_state, fp);
+    fclose(fp);
+    
+    if (n_written != n_serialized_state)
+    {
+        PyErr_SetString(bmeError, "Failed to write all state data");
+        return NULL;
+    }
+    
+    if (self->debug_mode == 1)
+        printf("Saved state to: %s\n", state_path);
+    
+    Py_RETURN_NONE;
+}
+
+BME_SERIALIZED_NOARGS(bme_save_bsec_state)
+
+static PyObject *bme_update_bsec_subscription_locked(BMEObject *self, PyObject *args)
+{
+    // Check if argument is a list
+    PyObject *list_obj;
+
+    if (!PyArg_ParseTuple(args, "O", &list_obj))
+    {
+        PyErr_SetString(bmeError, "Failed to parse Argument");
+        return (PyObject *)NULL;
+    }
+
+    if (!PyList_Check(list_obj))
+    {
+        PyErr_SetString(bmeError, "Argument must be a List");
+        return (PyObject *)NULL;
+    }
+    // Allocate required memory
+    uint8_t len = (uint8_t)PyList_Size(list_obj);
+
+    uint8_t n_requested_virtual_sensors;
+    n_requested_virtual_sensors = len;
+    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
+
+    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
+    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+
+    // Loop over list and parse into requested_virtual_sensors
+    PyObject *val;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        val = PyList_GetItem(list_obj, i);
+        if (!PyArg_ParseTuple(val, "bf", &(requested_virtual_sensors[i].sensor_id), &(requested_virtual_sensors[i].sample_rate)))
+        {
+            PyErr_SetString(bmeError, "List items must be tuples (sensor_id, sample_rate)");
+            return (PyObject *)NULL;
+        }
+    }
+
+    // Call bsec_update_subscription and return rslt
+    self->rslt = bsec_update_subscription(self->bsec_inst, requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
+
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_VARARGS(bme_update_bsec_subscription)
+
+static PyObject *bme_enable_gas_estimates_locked(BMEObject *self)
+{
+    uint8_t n_requested_virtual_sensors;
+    n_requested_virtual_sensors = 4;
+    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
+    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
+    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+
+    requested_virtual_sensors[0].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1;
+    requested_virtual_sensors[0].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
+    requested_virtual_sensors[1].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_2;
+    requested_virtual_sensors[1].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
+    requested_virtual_sensors[2].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_3;
+    requested_virtual_sensors[2].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
+    requested_virtual_sensors[3].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_4;
+    requested_virtual_sensors[3].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
+
+    self->rslt = bsec_update_subscription(self->bsec_inst, requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
+    printf("ENABLE GAS ESTIMATES RSLT %d\n", self->rslt);
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to subscribe gas estimates");
+        return (PyObject *)NULL;
+    }
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_NOARGS(bme_enable_gas_estimates)
+
+static PyObject *bme_disable_gas_estimates_locked(BMEObject *self)
+{
+    uint8_t n_requested_virtual_sensors;
+    n_requested_virtual_sensors = 4;
+    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
+    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
+    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+
+    requested_virtual_sensors[0].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1;
+    requested_virtual_sensors[0].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+    requested_virtual_sensors[1].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_2;
+    requested_virtual_sensors[1].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+    requested_virtual_sensors[2].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_3;
+    requested_virtual_sensors[2].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+    requested_virtual_sensors[3].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_4;
+    requested_virtual_sensors[3].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+
+    self->rslt = bsec_update_subscription(&(self->bme),requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
+
+    if (self->rslt != BSEC_OK)
+    {
+        PyErr_SetString(bmeError, "Failed to unsubscribe gas estimates");
+        return (PyObject *)NULL;
+    }
+    return Py_BuildValue("i", self->rslt);
+}
+
+BME_SERIALIZED_NOARGS(bme_disable_gas_estimates)
+#endif
+
+static PyMethodDef bme69x_methods[] = {
+    {"init_bme69x", (PyCFunction)bme_init_bme69x, METH_NOARGS, "Initialize the BME69X sensor"},
+    {"print_dur_prof", (PyCFunction)bme_print_dur_prof, METH_NOARGS, "Print the current duration profile"},
+    {"enable_debug_mode", (PyCFunction)bme_enable_debug_mode, METH_NOARGS, "Enable debug mode"},
+    {"disable_debug_mode", (PyCFunction)bme_disable_debug_mode, METH_NOARGS, "Disable debug mode"},
+    {"get_sensor_id", (PyCFunction)bme_get_sensor_id, METH_NOARGS, "Get unique sensor id"},
+    {"set_temp_offset", (PyCFunction)bme_set_temp_offset, METH_VARARGS, "Set temperature offset"},
+    {"get_chip_id", (PyCFunction)bme_get_chip_id, METH_NOARGS, "Get the chip ID"},
+    {"close_i2c", (PyCFunction)bme_close_i2c, METH_NOARGS, "Close the I2C bus"},
+    {"open_i2c", (PyCFunction)bme_open_i2c, METH_VARARGS, "Open the I2C bus and connect to I2C address"},
+    {"reconnect", (PyCFunction)bme_reconnect, METH_NOARGS, "Reopen the device and restore the sensor settings, keeping calibration and BSEC state"},
+    {"get_bus_stats", (PyCFunction)bme_get_bus_stats, METH_NOARGS, "Get transfer counters and latency histogram of this sensor"},
+    {"reset_bus_stats", (PyCFunction)bme_reset_bus_stats, METH_NOARGS, "Reset the transfer counters of this sensor"},
+    {"get_variant", (PyCFunction)bme_get_variant, METH_NOARGS, "Return string representing variant (BME690 or BME698)"},
+    {"set_conf", (PyCFunction)bme_set_conf, METH_VARARGS, "Configure the BME69X sensor"},
+    {"set_heatr_conf", (PyCFunction)bme_set_heatr_conf, METH_VARARGS, "Configure the BME69X heater"},
+    {"get_data", (PyCFunction)bme_get_data, METH_NOARGS, "Measure and read data from the BME69X sensor w/o BSEC"},
+    {"iter_fields", (PyCFunction)bme_iter_fields, METH_VARARGS, "Iterate over the fields of parallel/sequential mode as soon as they are measured"},
+#ifdef BSEC
+    {"subscribe_gas_estimates", (PyCFunction)bme_subscribe_gas_estimates, METH_VARARGS, "Subscribe to provided number of gas estimates"},
+    {"subscribe_ai_classes", (PyCFunction)bme_subscribe_ai_classes, METH_VARARGS, "Subscribe to all gas estimates"},
+    {"set_sample_rate", (PyCFunction)bme_set_sample_rate, METH_VARARGS, "Set the sample rate for all virtual sensors"},
+    {"get_bsec_version", (PyCFunction)bme_get_bsec_version, METH_NOARGS, "Return the BSEC version as string"},
+    {"get_digital_nose_data", (PyCFunction)bme_get_digital_nose_data, METH_NOARGS, "Measure Gas Estimates"},
+    {"get_bsec_data", (PyCFunction)bme_get_bsec_data, METH_NOARGS, "Measure and read data from the BME69x sensor with BSEC"},
+    {"wait_for_next_call", (PyCFunction)bme_wait_for_next_call, METH_NOARGS, "Sleep until BSEC wants the next measurement, then measure and return the BSEC data"},
+    {"trigger", (PyCFunction)bme_trigger, METH_NOARGS, "Start the measurement BSEC asks for and return when its data will be ready"},
+    {"collect", (PyCFunction)bme_collect, METH_NOARGS, "Read the measurement started by trigger() and return the BSEC data"},
+    {"start_acquisition", (PyCFunction)(void (*)(void))bme_start_acquisition, METH_VARARGS | METH_KEYWORDS, "Run the BSEC measurements in a background thread that queues the samples, optionally with real-time scheduling"},
+    {"stop_acquisition", (PyCFunction)bme_stop_acquisition, METH_NOARGS, "Stop the background acquisition thread"},
+    {"read_samples", (PyCFunction)bme_read_samples, METH_VARARGS, "Drain up to max_n queued samples as list of BSEC data dicts"},
+    {"try_read", (PyCFunction)bme_try_read, METH_NOARGS, "Return the next queued sample or None, never blocks"},
+    {"fileno", (PyCFunction)bme_fileno, METH_NOARGS, "File descriptor that is readable while samples are queued"},
+    {"next_sample", (PyCFunction)bme_next_sample, METH_NOARGS, "Awaitable that resolves to the next queued sample in the running asyncio loop"},
+    {"get_acquisition_stats", (PyCFunction)bme_get_acquisition_stats, METH_NOARGS, "Get queue depth, overrun, drop and error counters of the acquisition"},
+    {"get_bsec_timing_stats", (PyCFunction)bme_get_bsec_timing_stats, METH_NOARGS, "Get lateness, sample interval and warning counters of the BSEC calls"},
+    {"reset_bsec_timing_stats", (PyCFunction)bme_reset_bsec_timing_stats, METH_NOARGS, "Reset the BSEC timing counters of this sensor"},
+    {"get_bsec_conf", (PyCFunction)bme_get_bsec_conf, METH_NOARGS, "Get BSEC config as config integer array"},
+    {"set_bsec_conf", (PyCFunction)bme_set_bsec_conf, METH_VARARGS, "Set BSEC config from config integer array"},
+    {"get_bsec_state", (PyCFunction)bme_get_bsec_state, METH_NOARGS, "Get BSEC state"},
+    {"set_bsec_state", (PyCFunction)bme_set_bsec_state, METH_VARARGS, "Set BSEC state"},
+    {"load_bsec_conf", (PyCFunction)bme_load_bsec_conf, METH_NOARGS, "Load BSEC config from sensor-specific file"},
+    {"load_bsec_conf_from_file", (PyCFunction)bme_load_bsec_conf_from_file, METH_VARARGS, "Load BSEC config from a specific file path (auto-strips 4-byte header)"},
+    {"save_bsec_conf", (PyCFunction)bme_save_bsec_conf, METH_NOARGS, "Save BSEC config to sensor-specific file"},
+    {"load_bsec_state", (PyCFunction)bme_load_bsec_state, METH_NOARGS, "Load BSEC state from sensor-specific file"},
+    {"save_bsec_state", (PyCFunction)bme_save_bsec_state, METH_NOARGS, "Save BSEC state to sensor-specific file"},
+    {"update_bsec_subscription", (PyCFunction)bme_update_bsec_subscription, METH_VARARGS, "Update susbcribed BSEC outputs"},
+    {"enable_gas_estimates", (PyCFunction)bme_enable_gas_estimates, METH_NOARGS, "Enable all 4 gas estimates"},
+    {"disable_gas_estimates", (PyCFunction)bme_disable_gas_estimates, METH_NOARGS, "Disable all 4 gas estimates"},
+#endif
+    {NULL, NULL, 0, NULL} // Sentinel
+};
+
+static PyTypeObject BMEType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "bme69x.BME69X",
+    .tp_doc = "BME69X sensor object",
+    .tp_basicsize = sizeof(BMEObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = bme69x_new,
+    .tp_init = (initproc)bme69x_init_type,
+    .tp_dealloc = (destructor)bme69x_dealloc,
+    .tp_members = bme69x_members,
+    .tp_getset = bme69x_getset,
+    .tp_methods = bme69x_methods,
+};
+
+/* Order for bme_lock_batch() */
+static int bme_cmp_addr(const void *a, const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(BMEObject *const *)a;
+    uintptr_t pb = (uintptr_t)*(BMEObject *const *)b;
+
+    return (pa > pb) - (pa < pb);
+}
+
+/* Take the object locks of a batch in address order, so batches sharing
+ * sensors cannot deadlock. locked gets the n_locked distinct sensors. */
+static Py_ssize_t bme_lock_batch(BMEObject **sensors, Py_ssize_t n, BMEObject **locked)
+{
+    Py_ssize_t i, n_locked = 0;
+
+    memcpy(locked, sensors, n * sizeof(BMEObject *));
+    qsort(locked, n, sizeof(BMEObject *), bme_cmp_addr);
+    for (i = 0; i < n; i++)
+    {
+        if (n_locked == 0 || locked[n_locked - 1] != locked[i])
+        {
+            locked[n_locked] = locked[i];
+            bme_lock(locked[n_locked++]);
+        }
+    }
+
+    return n_locked;
+}
+
+static PyObject *bme_get_data_batch_locked(BMEObject **sensors, Py_ssize_t n);
+
+/* Module level get_data_batch(sensors)
+ * Triggers a forced measurement on every sensor, waits once for the longest
+ * measurement and then reads the FIELD0 burst of all sensors sharing a bus
+ * with one I2C transaction per mux channel (pi3g_bus_read_fields). Returns
+ * a list with one dict per sensor, same keys as get_data() in forced mode,
+ * or None for a sensor that could not be read. */
+static PyObject *bme_get_data_batch(PyObject *module, PyObject *args)
+{
+    PyObject *seq_arg;
+    PyObject *seq;
+    PyObject *pylist;
+    Py_ssize_t n, i, n_locked;
+
+    if (!PyArg_ParseTuple(args, "O", &seq_arg))
+    {
+        PyErr_SetString(bmeError, "Invalid argument: expected a sequence of BME69X objects");
+        return (PyObject *)NULL;
+    }
+
+    seq = PySequence_Fast(seq_arg, "Invalid argument: expected a sequence of BME69X objects");
+    if (seq == NULL)
+    {
+        return (PyObject *)NULL;
+    }
+
+    n = PySequence_Fast_GET_SIZE(seq);
+    if (n > UINT8_MAX)
+    {
+        Py_DECREF(seq);
+        PyErr_SetString(bmeError, "Too many sensors for one batch");
+        return (PyObject *)NULL;
+    }
+
+    BMEObject *sensors[n > 0 ? n : 1];
+    BMEObject *locked[n > 0 ? n : 1];
+
+    for (i = 0; i < n; i++)
+    {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        if (!PyObject_TypeCheck(item, &BMEType))
+        {
+            Py_DECREF(seq);
+            PyErr_SetString(bmeError, "Invalid argument: all items must be BME69X objects");
+            return (PyObject *)NULL;
+        }
+        sensors[i] = (BMEObject *)item;
+    }
+
+    n_locked = bme_lock_batch(sensors, n, locked);
+    pylist = bme_get_data_batch_locked(sensors, n);
+    for (i = 0; i < n_locked; i++)
+    {
+        bme_unlock(locked[i]);
+    }
+
+    Py_DECREF(seq);
+    return pylist;
+}
+
+static PyObject *bme_get_data_batch_locked(BMEObject **sensors, Py_ssize_t n)
+{
+    PyObject *pylist;
+    Py_ssize_t i, j;
+    uint32_t max_del_period = 0;
+    struct pi3g_intf *intfs[n > 0 ? n : 1];
+    uint8_t buffs[n > 0 ? n : 1][BME69X_LEN_FIELD];
+    int8_t rslts[n > 0 ? n : 1];
+    uint8_t done[n > 0 ? n : 1];
+
+    for (i = 0; i < n; i++)
+    {
+        if (sensors[i]->op_mode != BME69X_FORCED_MODE)
+        {
+            PyErr_SetString(bmeError, "get_data_batch() requires all sensors in forced mode");
+            return (PyObject *)NULL;
+        }
+        if (!pi3g_intf_is_open(&(sensors[i]->intf)))
+        {
+            PyErr_SetString(bmeError, "Device port of a sensor is closed");
+            return (PyObject *)NULL;
+        }
+    }
+
+    /* Start all measurements, then wait once for the slowest one. Sensors
+     * are visited mux channel by mux channel to save channel switches. */
+    uint8_t order[n > 0 ? n : 1];
+    for (i = 0; i < n; i++)
+    {
+        intfs[i] = &(sensors[i]->intf);
+    }
+    pi3g_mux_order(intfs, (uint8_t)n, order);
+    Py_BEGIN_ALLOW_THREADS
+    for (j = 0; j < n; j++)
+    {
+        i = order[j];
+        BMEObject *self = sensors[i];
+        BUS_TXN(self, self->rslt = bme69x_set_op_mode(BME69X_FORCED_MODE, &(self->bme)));
+        if (self->rslt != BME69X_OK)
+        {
+            perror("set_op_mode");
+        }
+        self->del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &(self->conf), &(self->bme)) + (self->heatr_conf.heatr_dur * 1000);
+        if (self->del_period > max_del_period)
+        {
+            max_del_period = self->del_period;
+        }
+        rslts[i] = self->rslt;
+        done[i] = 0;
+    }
+    pi3g_delay_us(max_del_period, NULL);
+
+    /* One bulk read per I2C bus, other transports read sensor by sensor */
+    for (i = 0; i < n; i++)
+    {
+        uint8_t n_intfs = 0;
+        Py_ssize_t idx[n];
+
+        if (done[i])
+        {
+            continue;
+        }
+        if (sensors[i]->intf.transport->id != PI3G_TRANSPORT_I2C)
+        {
+            if (rslts[i] == BME69X_OK)
+            {
+                BUS_TXN(sensors[i], rslts[i] = bme69x_get_regs(BME69X_REG_FIELD0, buffs[i], BME69X_LEN_FIELD, &(sensors[i]->bme)));
+            }
+            done[i] = 1;
+            continue;
+        }
+        for (j = i; j < n; j++)
+        {
+            if (!done[j] && sensors[j]->intf.transport->id == PI3G_TRANSPORT_I2C && sensors[j]->intf.bus == sensors[i]->intf.bus)
+            {
+                idx[n_intfs] = j;
+                intfs[n_intfs++] = &(sensors[j]->intf);
+                done[j] = 1;
+            }
+        }
+
+        int8_t grp_rslts[n_intfs];
+        uint8_t grp_buffs[n_intfs][BME69X_LEN_FIELD];
+        pi3g_bus_read_fields(intfs, n_intfs, grp_buffs, grp_rslts);
+        for (j = 0; j < n_intfs; j++)
+        {
+            memcpy(buffs[idx[j]], grp_buffs[j], BME69X_LEN_FIELD);
+            if (rslts[idx[j]] == BME69X_OK)
+            {
+                rslts[idx[j]] = grp_rslts[j];
+            }
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    pylist = PyList_New(n);
+    for (i = 0; i < n; i++)
+    {
+        BMEObject *self = sensors[i];
+        self->time_ms = pi3g_timestamp_ms();
+        self->rslt = rslts[i];
+        if (self->rslt == BME69X_OK)
+        {
+            self->rslt = bme69x_parse_field_data(buffs[i], &(self->data[0]), &(self->bme));
+            if (self->rslt == BME69X_OK)
+            {
+                self->n_fields = 1;
+            }
+            else if (self->rslt == BME69X_W_NO_NEW_DATA)
+            {
+                /* Measurement not finished yet, poll its status */
+                Py_BEGIN_ALLOW_THREADS
+                (void)bme69x_wait_data(0, &(self->bme));
+                BUS_TXN(self, self->rslt = bme69x_get_data(BME69X_FORCED_MODE, self->data, &(self->n_fields), &(self->bme)));
+                Py_END_ALLOW_THREADS
+            }
+        }
+
+        if (self->rslt == BME69X_OK && self->n_fields > 0)
+        {
+            PyList_SetItem(pylist, i, bme_forced_data_to_dict(self));
+        }
+        else
+        {
+            if (self->debug_mode)
+            {
+                printf("get_data_batch: sensor %d on bus %d failed (%d)\n", self->i2c_addr, self->i2c_bus, self->rslt);
+            }
+            Py_INCREF(Py_None);
+            PyList_SetItem(pylist, i, Py_None);
+        }
+    }
+
+    return pylist;
+}
+
+#ifdef BSEC
+/* bme69x.Scheduler(sensors): one native thread that runs the BSEC cycles
+ * of many sensors. A deadline heap holds, per sensor, either its next_call
+ * or the expected end of its running measurement. Every wake-up first
+ * triggers all sensors that are due and then harvests the finished ones,
+ * so the measurements of all sensors overlap. The samples go to the
+ * sensors' read_samples() queues. */
+
+/* Per-sensor state of a Scheduler */
+struct bme_sched_entry
+{
+    BMEObject *sensor;
+
+    /* 1 from trigger to harvest, the scheduler thread holds the sensor
+     * lock meanwhile */
+    uint8_t measuring;
+    bsec_bme_settings_t settings;
+    struct pi3g_bsec_sample sample;
+
+    /* Status polling of the running measurement, in us */
+    uint32_t polled;
+    uint32_t interval;
+
+    /* Counters, guarded by the scheduler mutex. Lateness is how long
+     * after next_call the measurement was triggered. */
+    uint64_t cycles;
+    uint64_t samples;
+    uint64_t errors;
+    int64_t lateness_last_ns;
+    int64_t lateness_max_ns;
+    int64_t lateness_sum_ns;
+    const char *last_error;
+};
+
+typedef struct
+{
+    PyObject_HEAD
+    struct bme_sched_entry *entries;
+    Py_ssize_t n;
+    struct pi3g_deadline *heap;
+    /* Scratch list of the due sensors of one wake-up */
+    uint32_t *due;
+    pthread_t thread;
+    uint8_t running;
+    struct bme_rt_opts rt;
+    /* Guards stop, the entry counters and the wake-up statistics */
+    uint8_t stop;
+    uint32_t spin_ns;
+    struct pi3g_wake_stats wake;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} SchedulerObject;
+
+static void bme_sched_error(SchedulerObject *sched, struct bme_sched_entry *entry, const char *error)
+{
+    pthread_mutex_lock(&(sched->mutex));
+    entry->errors++;
+    entry->last_error = error;
+    pthread_mutex_unlock(&(sched->mutex));
+}
+
+/* Start the measurement of a sensor that is due. Returns when to look at
+ * the sensor next. */
+static int64_t bme_sched_trigger(SchedulerObject *sched, struct bme_sched_entry *entry, int64_t now)
+{
+    BMEObject *sensor = entry->sensor;
+    const char *error = NULL;
+    int64_t lateness;
+    uint32_t wait_us;
+    int ret;
+
+    /* Never block on a sensor lock while holding others, a method call
+     * owns the sensor right now, try again shortly */
+    if (pthread_mutex_trylock(&(sensor->lock)) != 0)
+    {
+        return now + BME69X_POLL_MIN * 1000;
+    }
+    if (now < (int64_t)sensor->next_call)
+    {
+        pthread_mutex_unlock(&(sensor->lock));
+        return (int64_t)sensor->next_call;
+    }
+
+    /* The first cycle has no deadline to be late for */
+    lateness = sensor->next_call ? now - (int64_t)sensor->next_call : 0;
+    ret = bme_bsec_trigger(sensor, &(entry->settings), &(entry->sample), &error);
+
+    pthread_mutex_lock(&(sched->mutex));
+    entry->cycles++;
+    entry->lateness_last_ns = lateness;
+    entry->lateness_sum_ns += lateness;
+    if (lateness > entry->lateness_max_ns)
+    {
+        entry->lateness_max_ns = lateness;
+    }
+    pthread_mutex_unlock(&(sched->mutex));
+
+    if (ret <= 0)
+    {
+        pthread_mutex_unlock(&(sensor->lock));
+        if (ret < 0)
+        {
+            bme_sched_error(sched, entry, error);
+        }
+        return (int64_t)sensor->next_call;
+    }
+
+    /* Keep the sensor lock until the harvest */
+    entry->measuring = 1;
+    entry->polled = 0;
+    entry->interval = BME69X_POLL_MIN;
+    if (sched->rt.low_power)
+    {
+        /* One look after the expected end instead of polling up to it */
+        wait_us = sensor->del_period + BME69X_POLL_MARGIN;
+    }
+    else
+    {
+        wait_us = (sensor->del_period > BME69X_POLL_MARGIN) ? sensor->del_period - BME69X_POLL_MARGIN : 0;
+    }
+
+    return now + (int64_t)wait_us * 1000;
+}
+
+/* Read the measurement of a sensor once it is done, same polling as
+ * bme69x_wait_data() but without sleeping in it. Returns when to look at
+ * the sensor next. */
+static int64_t bme_sched_harvest(SchedulerObject *sched, struct bme_sched_entry *entry, int64_t now)
+{
+    BMEObject *sensor = entry->sensor;
+    const char *error = NULL;
+    uint8_t status = 0;
+    int8_t rslt;
+    int ret;
+
+    BUS_TXN(sensor, rslt = bme69x_get_regs(BME69X_REG_FIELD0, &status, 1, &(sensor->bme)));
+    if (rslt == BME69X_OK && !(status & BME69X_NEW_DATA_MSK) && entry->polled < BME69X_POLL_TIMEOUT)
+    {
+        int64_t next = now + (int64_t)entry->interval * 1000;
+
+        entry->polled += entry->interval;
+        entry->interval = (entry->interval * 2 > BME69X_POLL_MAX) ? BME69X_POLL_MAX : entry->interval * 2;
+        return next;
+    }
+
+    ret = bme_bsec_harvest(sensor, &(entry->settings), &(entry->sample), &error);
+    entry->measuring = 0;
+    pthread_mutex_unlock(&(sensor->lock));
+
+    if (ret < 0)
+    {
+        bme_sched_error(sched, entry, error);
+    }
+    else if (entry->sample.processed)
+    {
+        pi3g_sample_ring_push(sensor->acq_ring, &(entry->sample));
+        pthread_mutex_lock(&(sched->mutex));
+        entry->samples++;
+        pthread_mutex_unlock(&(sched->mutex));
+    }
+
+    return (int64_t)sensor->next_call;
+}
+
+static void *bme_sched_main(void *arg)
+{
+    SchedulerObject *sched = (SchedulerObject *)arg;
+    uint32_t *due = sched->due;
+    uint32_t spin_ns = bme_rt_spin_ns(&(sched->rt));
+    size_t n_heap = 0;
+    size_t n_trigger;
+    size_t n_harvest;
+    int64_t next;
+    int64_t now;
+
+    pthread_mutex_lock(&(sched->mutex));
+    sched->spin_ns = spin_ns;
+    pi3g_wake_stats_start(&(sched->wake));
+    pthread_mutex_unlock(&(sched->mutex));
+    for (Py_ssize_t i = 0; i < sched->n; i++)
+    {
+        pthread_mutex_lock(&(sched->entries[i].sensor->lock));
+        sched->entries[i].sensor->intf.spin_ns = spin_ns;
+        pthread_mutex_unlock(&(sched->entries[i].sensor->lock));
+    }
+
+    /* Look at every sensor right away, the trigger step sorts out the ones
+     * that are not due yet */
+    for (Py_ssize_t i = 0; i < sched->n; i++)
+    {
+        pi3g_heap_push(sched->heap, &n_heap, 0, (uint32_t)i);
+    }
+
+    for (;;)
+    {
+        if (bme_rt_wait(&(sched->mutex), &(sched->cond), &(sched->stop), sched->heap[0].deadline_ns, spin_ns, sched->rt.low_power, &(sched->wake)))
+        {
+            break;
+        }
+
+        /* Take out everything that is due, sensors to trigger from the
+         * front of due[] and sensors to harvest from the back */
+        now = pi3g_timestamp_ns();
+        n_trigger = 0;
+        n_harvest = 0;
+        while (n_heap > 0 && sched->heap[0].deadline_ns <= now)
+        {
+            struct pi3g_deadline d = pi3g_heap_pop(sched->heap, &n_heap);
+
+            if (sched->entries[d.id].measuring)
+            {
+                due[sched->n - 1 - n_harvest++] = d.id;
+            }
+            else
+            {
+                due[n_trigger++] = d.id;
+            }
+        }
+
+        /* Start the measurements first so they run while the finished ones
+         * are read and processed */
+        for (size_t i = 0; i < n_trigger; i++)
+        {
+            next = bme_sched_trigger(sched, &(sched->entries[due[i]]), pi3g_timestamp_ns());
+            pi3g_heap_push(sched->heap, &n_heap, next, due[i]);
+        }
+        for (size_t i = 0; i < n_harvest; i++)
+        {
+            uint32_t id = due[sched->n - 1 - i];
+
+            next = bme_sched_harvest(sched, &(sched->entries[id]), pi3g_timestamp_ns());
+            pi3g_heap_push(sched->heap, &n_heap, next, id);
+        }
+    }
+
+    /* Give back the sensors of unfinished measurements, their next
+     * get_bsec_data() starts a new one */
+    for (Py_ssize_t i = 0; i < sched->n; i++)
+    {
+        if (sched->entries[i].measuring)
+        {
+            sched->entries[i].measuring = 0;
+            pthread_mutex_unlock(&(sched->entries[i].sensor->lock));
+        }
+    }
+
+    /* Then drop the spin margin of the measurement delays again, holding
+     * one sensor lock at a time */
+    for (Py_ssize_t i = 0; i < sched->n; i++)
+    {
+        pthread_mutex_lock(&(sched->entries[i].sensor->lock));
+        sched->entries[i].sensor->intf.spin_ns = 0;
+        pthread_mutex_unlock(&(sched->entries[i].sensor->lock));
+    }
+    return NULL;
+}
+
+/* Stop the scheduler thread and give the sensors back, called with the
+ * GIL held */
+static void bme_sched_join(SchedulerObject *sched)
+{
+    if (!sched->running)
+    {
+        return;
+    }
+    pthread_mutex_lock(&(sched->mutex));
+    sched->stop = 1;
+    pthread_cond_signal(&(sched->cond));
+    pthread_mutex_unlock(&(sched->mutex));
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(sched->thread, NULL);
+    Py_END_ALLOW_THREADS
+    sched->running = 0;
+
+    for (Py_ssize_t i = 0; i < sched->n; i++)
+    {
+        sched->entries[i].sensor->acq_running = BME_ACQ_OFF;
+        if (bme_waiters_fail(sched->entries[i].sensor, "Scheduler was stopped") < 0)
+        {
+            PyErr_WriteUnraisable(NULL);
+        }
+    }
+}
+
+static void
+bme_sched_dealloc(SchedulerObject *self)
+{
+    bme_sched_join(self);
+    for (Py_ssize_t i = 0; i < self->n; i++)
+    {
+        Py_XDECREF(self->entries[i].sensor);
+    }
+    PyMem_Free(self->entries);
+    PyMem_Free(self->heap);
+    PyMem_Free(self->due);
+    pthread_cond_destroy(&(self->cond));
+    pthread_mutex_destroy(&(self->mutex));
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+bme_sched_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    SchedulerObject *self;
+    self = (SchedulerObject *)type->tp_alloc(type, 0);
+    if (self != NULL)
+    {
+        self->entries = NULL;
+        self->n = 0;
+        self->heap = NULL;
+        self->due = NULL;
+        self->running = 0;
+        self->stop = 0;
+        self->spin_ns = 0;
+        memset(&(self->wake), 0, sizeof(self->wake));
+
+        pthread_condattr_t condattr;
+        pthread_condattr_init(&condattr);
+        pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+        pthread_cond_init(&(self->cond), &condattr);
+        pthread_condattr_destroy(&condattr);
+        pthread_mutex_init(&(self->mutex), NULL);
+    }
+    return (PyObject *)self;
+}
+
+static int
+bme_sched_init_type(SchedulerObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"sensors", NULL};
+    PyObject *pysensors;
+    PyObject *seq;
+    Py_ssize_t n;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &pysensors))
+    {
+        return -1;
+    }
+    if (self->entries != NULL)
+    {
+        PyErr_SetString(bmeError, "Scheduler is already initialized");
+        return -1;
+    }
+
+    seq = PySequence_Fast(pysensors, "sensors must be a list of BME69X objects");
+    if (seq == NULL)
+    {
+        return -1;
+    }
+    n = PySequence_Fast_GET_SIZE(seq);
+    if (n == 0)
+    {
+        Py_DECREF(seq);
+        PyErr_SetString(bmeError, "Scheduler needs at least one sensor");
+        return -1;
+    }
+
+    self->entries = PyMem_Calloc((size_t)n, sizeof(struct bme_sched_entry));
+    self->heap = PyMem_Calloc((size_t)n, sizeof(struct pi3g_deadline));
+    self->due = PyMem_Calloc((size_t)n, sizeof(uint32_t));
+    if (self->entries == NULL || self->heap == NULL || self->due == NULL)
+    {
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (Py_ssize_t i = 0; i < n; i++)
+    {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+
+        if (!PyObject_TypeCheck(item, &BMEType))
+        {
+            Py_DECREF(seq);
+            PyErr_SetString(bmeError, "sensors must be a list of BME69X objects");
+            return -1;
+        }
+        for (Py_ssize_t j = 0; j < self->n; j++)
+        {
+            if (self->entries[j].sensor == (BMEObject *)item)
+            {
+                Py_DECREF(seq);
+                PyErr_SetString(bmeError, "Sensor is listed twice");
+                return -1;
+            }
+        }
+        Py_INCREF(item);
+        self->entries[i].sensor = (BMEObject *)item;
+        self->n = i + 1;
+    }
+    Py_DECREF(seq);
+
+    return 0;
 }
 
-/* Load BSEC state from sensor-specific file */
-static PyObject *bme_load_bsec_state(BMEObject *self)
+static PyObject *bme_sched_start(SchedulerObject *self, PyObject *args, PyObject *kwds)
 {
-    char state_path[256];
-    get_state_filename(self->sensor_id, state_path, sizeof(state_path));
-    
-    FILE *fp = fopen(state_path, "rb");
-    if (!fp)
+    struct bme_rt_opts rt;
+
+    if (bme_rt_parse(args, kwds, &rt) < 0)
     {
-        if (self->debug_mode == 1)
-            printf("State file not found: %s (this is OK for first run)\n", state_path);
-        Py_RETURN_NONE;
+        return NULL;
     }
-    
-    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
-    size_t n_read = fread(serialized_state, 1, BSEC_MAX_STATE_BLOB_SIZE, fp);
-    fclose(fp);
-    
-    if (n_read == 0)
+    if (self->running)
     {
-        PyErr_SetString(bmeError, "Failed to read state file");
+        PyErr_SetString(bmeError, "Scheduler is already running");
         return NULL;
     }
-    
-    uint8_t work_buffer[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_work_buffer = BSEC_MAX_STATE_BLOB_SIZE;
-    
-    self->rslt = bsec_set_state(self->bsec_inst, serialized_state, n_read, work_buffer, n_work_buffer);
-    if (self->rslt != BSEC_OK)
+    if (self->n == 0)
     {
-        PyErr_SetString(bmeError, "Failed to apply loaded state to BSEC");
+        PyErr_SetString(bmeError, "Scheduler has no sensors");
         return NULL;
     }
-    
-    if (self->debug_mode == 1)
-        printf("Loaded state from: %s\n", state_path);
-    
-    Py_RETURN_NONE;
-}
-
-/* Save BSEC state to sensor-specific file */
-static PyObject *bme_save_bsec_state(BMEObject *self)
-{
-    char state_path[256];
-    get_state_filename(self->sensor_id, state_path, sizeof(state_path));
-    
-    uint8_t state_set_id = 0;
-    uint8_t serialized_state[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_serialized_state_max = BSEC_MAX_STATE_BLOB_SIZE;
-    uint32_t n_serialized_state = BSEC_MAX_STATE_BLOB_SIZE;
-    uint8_t work_buffer_state[BSEC_MAX_STATE_BLOB_SIZE];
-    uint32_t n_work_buffer_state = BSEC_MAX_STATE_BLOB_SIZE;
-    
-    self->rslt = bsec_get_state(self->bsec_inst, state_set_id, serialized_state, n_serialized_state_max,
-                                work_buffer_state, n_work_buffer_state, &n_serialized_state);
-    if (self->rslt != BSEC_OK)
+    for (Py_ssize_t i = 0; i < self->n; i++)
     {
-        PyErr_SetString(bmeError, "Failed to get BSEC state");
-        return NULL;
+        if (self->entries[i].sensor->acq_running)
+        {
+            PyErr_Format(bmeError, "Acquisition of %s is already running", self->entries[i].sensor->sensor_id);
+            return NULL;
+        }
+        if (bme_bsec_check_idle(self->entries[i].sensor) < 0 || bme_acq_ring_alloc(self->entries[i].sensor) < 0)
+        {
+            return NULL;
+        }
     }
-    
-    FILE *fp = fopen(state_path, "wb");
-    if (!fp)
+
+    self->rt = rt;
+    self->stop = 0;
+    memset(&(self->wake), 0, sizeof(self->wake));
+    if (bme_rt_thread_create(&(self->thread), &(self->rt), bme_sched_main, self) < 0)
     {
-        PyErr_SetString(bmeError, "Failed to open state file for writing");
         return NULL;
     }
-    
-    size_t n_written = fwrite(serialized_state, 1, n_serialized_state, fp);
-    fclose(fp);
-    
-    if (n_written != n_serialized_state)
+    self->running = 1;
+    for (Py_ssize_t i = 0; i < self->n; i++)
     {
-        PyErr_SetString(bmeError, "Failed to write all state data");
-        return NULL;
+        self->entries[i].sensor->acq_running = BME_ACQ_SCHEDULER;
     }
-    
-    if (self->debug_mode == 1)
-        printf("Saved state to: %s\n", state_path);
-    
+
     Py_RETURN_NONE;
 }
 
-static PyObject *bme_update_bsec_subscription(BMEObject *self, PyObject *args)
+static PyObject *bme_sched_stop(SchedulerObject *self, PyObject *Py_UNUSED(ignored))
 {
-    // Check if argument is a list
-    PyObject *list_obj;
+    bme_sched_join(self);
+    Py_RETURN_NONE;
+}
 
-    if (!PyArg_ParseTuple(args, "O", &list_obj))
+/* Per-sensor counters as list of dicts in the order of the sensors,
+ * lateness in us */
+static PyObject *bme_sched_get_stats(SchedulerObject *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *pylist = PyList_New(self->n);
+    if (pylist == NULL)
     {
-        PyErr_SetString(bmeError, "Failed to parse Argument");
-        return (PyObject *)NULL;
+        return NULL;
     }
 
-    if (!PyList_Check(list_obj))
+    for (Py_ssize_t i = 0; i < self->n; i++)
     {
-        PyErr_SetString(bmeError, "Argument must be a List");
-        return (PyObject *)NULL;
-    }
-    // Allocate required memory
-    uint8_t len = (uint8_t)PyList_Size(list_obj);
+        struct bme_sched_entry entry;
+        PyObject *stats = PyDict_New();
+        if (stats == NULL)
+        {
+            Py_DECREF(pylist);
+            return NULL;
+        }
 
-    uint8_t n_requested_virtual_sensors;
-    n_requested_virtual_sensors = len;
-    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
+        pthread_mutex_lock(&(self->mutex));
+        entry = self->entries[i];
+        pthread_mutex_unlock(&(self->mutex));
+
+        DICT_SET_ITEM(stats, "sensor_id", Py_BuildValue("s", entry.sensor->sensor_id));
+        DICT_SET_ITEM(stats, "cycles", Py_BuildValue("K", (unsigned long long)entry.cycles));
+        DICT_SET_ITEM(stats, "samples", Py_BuildValue("K", (unsigned long long)entry.samples));
+        DICT_SET_ITEM(stats, "errors", Py_BuildValue("K", (unsigned long long)entry.errors));
+        DICT_SET_ITEM(stats, "lateness_us", Py_BuildValue("L", (long long)(entry.lateness_last_ns / 1000)));
+        DICT_SET_ITEM(stats, "max_lateness_us", Py_BuildValue("L", (long long)(entry.lateness_max_ns / 1000)));
+        DICT_SET_ITEM(stats, "mean_lateness_us", Py_BuildValue("d", entry.cycles ? (double)entry.lateness_sum_ns / entry.cycles / 1000.0 : 0.0));
+        if (entry.last_error)
+        {
+            DICT_SET_ITEM(stats, "last_error", Py_BuildValue("s", entry.last_error));
+        }
+        else
+        {
+            Py_INCREF(Py_None);
+            DICT_SET_ITEM(stats, "last_error", Py_None);
+        }
+        PyList_SET_ITEM(pylist, i, stats);
+    }
+    return pylist;
+}
 
-    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
-    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+/* Wake-up error of the scheduler thread, in us */
+static PyObject *bme_sched_get_wake_stats(SchedulerObject *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *stats = PyDict_New();
+    struct pi3g_wake_stats wake;
+    uint32_t spin_ns;
 
-    // Loop over list and parse into requested_virtual_sensors
-    PyObject *val;
-    for (uint8_t i = 0; i < len; i++)
+    if (stats == NULL)
     {
-        val = PyList_GetItem(list_obj, i);
-        if (!PyArg_ParseTuple(val, "bf", &(requested_virtual_sensors[i].sensor_id), &(requested_virtual_sensors[i].sample_rate)))
-        {
-            PyErr_SetString(bmeError, "List items must be tuples (sensor_id, sample_rate)");
-            return (PyObject *)NULL;
-        }
+        return NULL;
     }
 
-    // Call bsec_update_subscription and return rslt
-    self->rslt = bsec_update_subscription(self->bsec_inst, requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
+    pthread_mutex_lock(&(self->mutex));
+    wake = self->wake;
+    spin_ns = self->spin_ns;
+    pthread_mutex_unlock(&(self->mutex));
 
-    return Py_BuildValue("i", self->rslt);
+    bme_wake_stats_to_dict(stats, &wake, spin_ns);
+    return stats;
 }
 
-static PyObject *bme_enable_gas_estimates(BMEObject *self)
+static PyObject *bme_sched_get_sensors(SchedulerObject *self, void *closure)
 {
-    uint8_t n_requested_virtual_sensors;
-    n_requested_virtual_sensors = 4;
-    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
-    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
-    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+    PyObject *pylist = PyList_New(self->n);
+    if (pylist == NULL)
+    {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < self->n; i++)
+    {
+        Py_INCREF(self->entries[i].sensor);
+        PyList_SET_ITEM(pylist, i, (PyObject *)self->entries[i].sensor);
+    }
+    return pylist;
+}
 
-    requested_virtual_sensors[0].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1;
-    requested_virtual_sensors[0].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
-    requested_virtual_sensors[1].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_2;
-    requested_virtual_sensors[1].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
-    requested_virtual_sensors[2].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_3;
-    requested_virtual_sensors[2].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
-    requested_virtual_sensors[3].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_4;
-    requested_virtual_sensors[3].sample_rate = BSEC_SAMPLE_RATE_SCAN ;
+static PyObject *bme_sched_get_running(SchedulerObject *self, void *closure)
+{
+    return PyBool_FromLong(self->running);
+}
 
-    self->rslt = bsec_update_subscription(self->bsec_inst, requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
-    printf("ENABLE GAS ESTIMATES RSLT %d\n", self->rslt);
-    if (self->rslt != BSEC_OK)
+static PyGetSetDef bme_sched_getset[] = {
+    {"sensors", (getter)bme_sched_get_sensors, NULL, "Sensors run by this scheduler", NULL},
+    {"running", (getter)bme_sched_get_running, NULL, "True while the scheduler thread runs", NULL},
+    {NULL} // Sentinel
+};
+
+static PyMethodDef bme_sched_methods[] = {
+    {"start", (PyCFunction)(void (*)(void))bme_sched_start, METH_VARARGS | METH_KEYWORDS, "Start running the BSEC cycles of all sensors in one background thread, optionally with real-time scheduling"},
+    {"stop", (PyCFunction)bme_sched_stop, METH_NOARGS, "Stop the scheduler thread"},
+    {"get_wake_stats", (PyCFunction)bme_sched_get_wake_stats, METH_NOARGS, "Get the wake-up error statistics of the scheduler thread"},
+    {"get_stats", (PyCFunction)bme_sched_get_stats, METH_NOARGS, "Get per-sensor cycle, sample, error and lateness counters"},
+    {NULL, NULL, 0, NULL} // Sentinel
+};
+
+static PyTypeObject SchedulerType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "bme69x.Scheduler",
+    .tp_doc = "Earliest-deadline-first scheduler for the BSEC cycles of several BME69X sensors",
+    .tp_basicsize = sizeof(SchedulerObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = bme_sched_new,
+    .tp_init = (initproc)bme_sched_init_type,
+    .tp_dealloc = (destructor)bme_sched_dealloc,
+    .tp_getset = bme_sched_getset,
+    .tp_methods = bme_sched_methods,
+};
+#endif
+
+/* Module level set_clock(name, start_ns=-1): "real" or "virtual" */
+static PyObject *bme_set_clock(PyObject *module, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"name", "start_ns", NULL};
+    const char *name;
+    long long start_ns = -1;
+    int8_t rslt;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|L", kwlist, &name, &start_ns))
     {
-        PyErr_SetString(bmeError, "Failed to subscribe gas estimates");
-        return (PyObject *)NULL;
+        return NULL;
     }
-    return Py_BuildValue("i", self->rslt);
+    rslt = pi3g_set_clock(name, (int64_t)start_ns);
+    if (rslt == -2)
+    {
+        PyErr_SetString(bmeError, "The virtual clock is ahead of the real clock, switching back would move time backwards. Use the virtual clock in a process of its own");
+        return NULL;
+    }
+    if (rslt != 0)
+    {
+        PyErr_Format(bmeError, "Unknown clock '%s', use 'real' or 'virtual'", name);
+        return NULL;
+    }
+    return Py_BuildValue("L", (long long)pi3g_timestamp_ns());
 }
 
-static PyObject *bme_disable_gas_estimates(BMEObject *self)
+static PyObject *bme_get_clock(PyObject *module, PyObject *Py_UNUSED(ignored))
 {
-    uint8_t n_requested_virtual_sensors;
-    n_requested_virtual_sensors = 4;
-    bsec_sensor_configuration_t requested_virtual_sensors[n_requested_virtual_sensors];
-    bsec_sensor_configuration_t required_sensor_settings[BSEC_MAX_PHYSICAL_SENSOR];
-    uint8_t n_required_sensor_settings = BSEC_MAX_PHYSICAL_SENSOR;
+    return Py_BuildValue("s", pi3g_clock_name());
+}
 
-    requested_virtual_sensors[0].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_1;
-    requested_virtual_sensors[0].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
-    requested_virtual_sensors[1].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_2;
-    requested_virtual_sensors[1].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
-    requested_virtual_sensors[2].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_3;
-    requested_virtual_sensors[2].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
-    requested_virtual_sensors[3].sensor_id = BSEC_OUTPUT_GAS_ESTIMATE_4;
-    requested_virtual_sensors[3].sample_rate = BSEC_SAMPLE_RATE_DISABLED;
+static PyObject *bme_clock_ns(PyObject *module, PyObject *Py_UNUSED(ignored))
+{
+    return Py_BuildValue("L", (long long)pi3g_timestamp_ns());
+}
 
-    self->rslt = bsec_update_subscription(&(self->bme),requested_virtual_sensors, n_requested_virtual_sensors, required_sensor_settings, &n_required_sensor_settings);
+static PyObject *bme_advance_clock(PyObject *module, PyObject *args)
+{
+    long long duration_ns;
 
-    if (self->rslt != BSEC_OK)
+    if (!PyArg_ParseTuple(args, "L", &duration_ns))
     {
-        PyErr_SetString(bmeError, "Failed to unsubscribe gas estimates");
-        return (PyObject *)NULL;
+        return NULL;
     }
-    return Py_BuildValue("i", self->rslt);
+    if (!pi3g_clock_is_virtual())
+    {
+        PyErr_SetString(bmeError, "advance_clock() needs the virtual clock, call set_clock('virtual') first");
+        return NULL;
+    }
+    return Py_BuildValue("L", (long long)pi3g_clock_advance_ns((int64_t)duration_ns));
 }
-#endif
 
-static PyMethodDef bme69x_methods[] = {
-    {"init_bme69x", (PyCFunction)bme_init_bme69x, METH_NOARGS, "Initialize the BME69X sensor"},
-    {"print_dur_prof", (PyCFunction)bme_print_dur_prof, METH_NOARGS, "Print the current duration profile"},
-    {"enable_debug_mode", (PyCFunction)bme_enable_debug_mode, METH_NOARGS, "Enable debug mode"},
-    {"disable_debug_mode", (PyCFunction)bme_disable_debug_mode, METH_NOARGS, "Disable debug mode"},
-    {"get_sensor_id", (PyCFunction)bme_get_sensor_id, METH_NOARGS, "Get unique sensor id"},
-    {"set_temp_offset", (PyCFunction)bme_set_temp_offset, METH_VARARGS, "Set temperature offset"},
-    {"get_chip_id", (PyCFunction)bme_get_chip_id, METH_NOARGS, "Get the chip ID"},
-    {"close_i2c", (PyCFunction)bme_close_i2c, METH_NOARGS, "Close the I2C bus"},
-    {"open_i2c", (PyCFunction)bme_open_i2c, METH_VARARGS, "Open the I2C bus and connect to I2C address"},
-    {"get_variant", (PyCFunction)bme_get_variant, METH_NOARGS, "Return string representing variant (BME690 or BME698)"},
-    {"set_conf", (PyCFunction)bme_set_conf, METH_VARARGS, "Configure the BME69X sensor"},
-    {"set_heatr_conf", (PyCFunction)bme_set_heatr_conf, METH_VARARGS, "Configure the BME69X heater"},
-    {"get_data", (PyCFunction)bme_get_data, METH_NOARGS, "Measure and read data from the BME69X sensor w/o BSEC"},
-#ifdef BSEC
-    {"subscribe_gas_estimates", (PyCFunction)bme_subscribe_gas_estimates, METH_VARARGS, "Subscribe to provided number of gas estimates"},
-    {"subscribe_ai_classes", (PyCFunction)bme_subscribe_ai_classes, METH_VARARGS, "Subscribe to all gas estimates"},
-    {"set_sample_rate", (PyCFunction)bme_set_sample_rate, METH_VARARGS, "Set the sample rate for all virtual sensors"},
-    {"get_bsec_version", (PyCFunction)bme_get_bsec_version, METH_NOARGS, "Return the BSEC version as string"},
-    {"get_digital_nose_data", (PyCFunction)bme_get_digital_nose_data, METH_NOARGS, "Measure Gas Estimates"},
-    {"get_bsec_data", (PyCFunction)bme_get_bsec_data, METH_NOARGS, "Measure and read data from the BME69x sensor with BSEC"},
-    {"get_bsec_conf", (PyCFunction)bme_get_bsec_conf, METH_NOARGS, "Get BSEC config as config integer array"},
-    {"set_bsec_conf", (PyCFunction)bme_set_bsec_conf, METH_VARARGS, "Set BSEC config from config integer array"},
-    {"get_bsec_state", (PyCFunction)bme_get_bsec_state, METH_NOARGS, "Get BSEC state"},
-    {"set_bsec_state", (PyCFunction)bme_set_bsec_state, METH_VARARGS, "Set BSEC state"},
-    {"load_bsec_conf", (PyCFunction)bme_load_bsec_conf, METH_NOARGS, "Load BSEC config from sensor-specific file"},
-    {"load_bsec_conf_from_file", (PyCFunction)bme_load_bsec_conf_from_file, METH_VARARGS, "Load BSEC config from a specific file path (auto-strips 4-byte header)"},
-    {"save_bsec_conf", (PyCFunction)bme_save_bsec_conf, METH_NOARGS, "Save BSEC config to sensor-specific file"},
-    {"load_bsec_state", (PyCFunction)bme_load_bsec_state, METH_NOARGS, "Load BSEC state from sensor-specific file"},
-    {"save_bsec_state", (PyCFunction)bme_save_bsec_state, METH_NOARGS, "Save BSEC state to sensor-specific file"},
-    {"update_bsec_subscription", (PyCFunction)bme_update_bsec_subscription, METH_VARARGS, "Update susbcribed BSEC outputs"},
-    {"enable_gas_estimates", (PyCFunction)bme_enable_gas_estimates, METH_NOARGS, "Enable all 4 gas estimates"},
-    {"disable_gas_estimates", (PyCFunction)bme_disable_gas_estimates, METH_NOARGS, "Disable all 4 gas estimates"},
-#endif
+static PyMethodDef bme69x_module_methods[] = {
+    {"get_data_batch", (PyCFunction)bme_get_data_batch, METH_VARARGS, "Measure and read data from several BME69X sensors in forced mode, one I2C transaction per bus"},
+    {"set_clock", (PyCFunction)(void (*)(void))bme_set_clock, METH_VARARGS | METH_KEYWORDS, "Select the real or the virtual clock for all sensors, returns the current time in ns"},
+    {"get_clock", (PyCFunction)bme_get_clock, METH_NOARGS, "Name of the clock in use"},
+    {"clock_ns", (PyCFunction)bme_clock_ns, METH_NOARGS, "Current time in ns on the clock in use, the clock of all timestamps and next_call"},
+    {"advance_clock", (PyCFunction)bme_advance_clock, METH_VARARGS, "Move the virtual clock on by ns without sleeping, returns the new time"},
     {NULL, NULL, 0, NULL} // Sentinel
 };
 
-static PyTypeObject BMEType = {
-    PyVarObject_HEAD_INIT(NULL, 0)
-        .tp_name = "bme69x.BME69X",
-    .tp_doc = "BME69X sensor object",
-    .tp_basicsize = sizeof(BMEObject),
-    .tp_itemsize = 0,
-    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
-    .tp_new = bme69x_new,
-    .tp_init = (initproc)bme69x_init_type,
-    .tp_dealloc = (destructor)bme69x_dealloc,
-    .tp_members = bme69x_members,
-    .tp_methods = bme69x_methods,
-};
-
 static PyModuleDef custommodule = {
     PyModuleDef_HEAD_INIT,
     .m_name = "bme69x",
     .m_doc = "Example module that creates an extension type.",
     .m_size = -1,
+    .m_methods = bme69x_module_methods,
 };
 
 PyMODINIT_FUNC
@@ -2037,6 +4521,12 @@ PyInit_bme69x(void)
     PyObject *m;
     if (PyType_Ready(&BMEType) < 0)
         return NULL;
+    if (PyType_Ready(&FieldIterType) < 0)
+        return NULL;
+#ifdef BSEC
+    if (PyType_Ready(&SchedulerType) < 0)
+        return NULL;
+#endif
 
     m = PyModule_Create(&custommodule);
     if (m == NULL)
@@ -2060,6 +4550,16 @@ PyInit_bme69x(void)
         return NULL;
     }
 
+#ifdef BSEC
+    Py_INCREF(&SchedulerType);
+    if (PyModule_AddObject(m, "Scheduler", (PyObject *)&SchedulerType) < 0)
+    {
+        Py_DECREF(&SchedulerType);
+        Py_DECREF(m);
+        return NULL;
+    }
+#endif
+
     PyModule_AddIntConstant(m, "BME69X_I2C_ADDR_LOW", 0x76);
     PyModule_AddIntConstant(m, "BME69X_I2C_ADDR_HIGH", 0x77);
     PyModule_AddIntConstant(m, "BME69X_CHIP_ID", 0x61);
@@ -12,7 +12,6 @@ from bme69x import BME69X
 import bme69xConstants as cnst
 import bsecConstants as bsec
 import gpiozero as gpio
-from time import sleep
 
 GRN = gpio.LED(17)
 YLW = gpio.LED(27)
@@ -44,15 +43,14 @@ bme.set_sample_rate(bsec.BSEC_SAMPLE_RATE_LP)
 def get_data(sensor):
     data = {}
     try:
-        data = sensor.get_bsec_data()
+        # Sleeps until BSEC wants the next sample, no polling needed
+        data = sensor.wait_for_next_call()
     except Exception as e:
         print(e)
         return None
-    if data == None or data == {}:
-        sleep(0.1)
+    if data == {}:
         return None
     else:
-        sleep(3)
         return data
 
 
@@ -43,16 +43,14 @@ start_time = time()
 def get_data(bme):
     data = {}
     try:
-        # Read BSEC data
-        data = bme.get_bsec_data()
+        # Sleep until BSEC wants the next sample, then read BSEC data
+        data = bme.wait_for_next_call()
     except Exception as e:
         print(e)
         return None
-    if data == None or data == {}:
-        sleep(1)
+    if data == {}:
         return None
     else:
-        sleep(3)
         return data
 
 # Main loop
@@ -63,7 +61,6 @@ while True:
         bsec_data = get_data(bme)
     #
     print(bsec_data)
-    sleep(1)
     # Run the sensor for 24 hours and check the IAQ qulity is 3 (Best Quality)
     # 24 hours in seconds is 86400
     # If the test succeeds write out the state and config data to files in the conf subdirectory.
@@ -138,7 +138,7 @@ def main():
         print("\nThis is expected if sensor is not connected.")
         print("The multi-sensor API is ready for use when hardware is available.\n")
         print("API Summary:")
-        print("  • Each BME69X() instance gets its own I2C file descriptor")
+        print("  • BME69X() instances on the same bus share one I2C handle")
         print("  • Each instance gets its own BSEC state/config in memory")
         print("  • Each instance's state/config saves to sensor-specific files")
         print("  • Supports multiple sensors on same I2C bus (different addresses)")
@@ -24,7 +24,7 @@ print()
 
 def get_data(sensor):
     try:
-        data = sensor.get_bsec_data()
+        data = sensor.wait_for_next_call()
         return data if data else None
     except Exception as e:
         print(f"Error: {e}")
@@ -66,8 +66,6 @@ try:
             
             print()
         
-        sleep(3)  # LP mode samples every ~3 seconds
-        
 except KeyboardInterrupt:
     print("\n\nTest stopped by user")
     print(f"Total samples: {sample_count}")
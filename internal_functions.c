@@ -1,88 +1,1432 @@
+#define _GNU_SOURCE /* CPU_SET, pthread_attr_setaffinity_np */
 #define _XOPEN_SOURCE 700
 #define TEMP_OFFSET 0.0f
 #define BSEC
 
 #include "internal_functions.h"
 
-struct bme69x_data data[3];
-uint32_t del_period;
-uint32_t time_ms;
-uint8_t n_fields;
-static int8_t rslt;
+#ifdef BSEC
+/* TVOC equivalent baseline tracker constants */
+#define TVOC_EQUIVALENT_ENABLE    3
+#define TVOC_EQUIVALENT_DISABLE   0
+#define TVOC_CALIBRATION_TIME_SEC (30 * 60)  /* 30 minutes in seconds */
+
+/* Global variable for baseline tracker */
+static uint8_t baseline_tracker = TVOC_EQUIVALENT_DISABLE;
+/* Global variable to track the current sample rate */
+static float current_sample_rate = 0.0f;
+/* TVOC calibration tracking variables */
+static time_t tvoc_start_time = 0;
+static bool tvoc_disable_flag = false;
+static bool tvoc_calibration_started = false;
+/* Guards the variables above, sensors are sampled from several threads */
+static pthread_mutex_t tvoc_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Buses opened through pi3g_bus_open */
+static struct pi3g_bus *bus_list = NULL;
+static pthread_mutex_t bus_list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Point the shared fd at addr for write()/read() transfers, bus lock held */
+static int set_slave_addr(struct pi3g_bus *bus, uint8_t addr)
+{
+    if (bus->slave_addr != addr)
+    {
+        if (ioctl(bus->fd, I2C_SLAVE, addr) < 0)
+        {
+            perror("I2C_SLAVE");
+            bus->slave_addr = -1;
+            return -1;
+        }
+        bus->slave_addr = addr;
+    }
+
+    return 0;
+}
+
+/* Fill msgs with the mux control register writes that connect intf to the
+ * bus: the other muxes in use are switched off and the mux of intf is set
+ * to its channel, writes already in effect are skipped. For a sensor on the
+ * bus itself every mux in use is switched off, so a muxed device at the
+ * same address cannot answer too. The mux state is updated right away,
+ * mux_invalidate has to follow a failed write. Returns the number of
+ * messages, at most PI3G_MUX_N. Called with the bus lock held. */
+static uint8_t mux_route(struct pi3g_bus *bus, const struct pi3g_intf *intf, struct i2c_msg *msgs, uint8_t *ctrl)
+{
+    uint8_t n = 0;
+    uint8_t want;
+
+    for (uint8_t i = 0; i < PI3G_MUX_N; i++)
+    {
+        if (!(bus->mux_used & (1u << i)))
+        {
+            continue;
+        }
+
+        want = (intf->mux_addr == PI3G_MUX_ADDR_MIN + i) ? (uint8_t)(1u << intf->mux_channel) : 0;
+        if (bus->mux_ctrl[i] == want)
+        {
+            continue;
+        }
+
+        ctrl[n] = want;
+        msgs[n].addr = PI3G_MUX_ADDR_MIN + i;
+        msgs[n].flags = 0;
+        msgs[n].len = 1;
+        msgs[n].buf = &ctrl[n];
+        bus->mux_ctrl[i] = want;
+        bus->mux_switches++;
+        n++;
+    }
+
+    return n;
+}
+
+/* Forget the mux state, the next transfer writes every control register again */
+static void mux_invalidate(struct pi3g_bus *bus)
+{
+    for (uint8_t i = 0; i < PI3G_MUX_N; i++)
+    {
+        bus->mux_ctrl[i] = PI3G_MUX_UNKNOWN;
+    }
+}
+
+/* Connect intf to the bus, see mux_route. A TCA9548A/PCA954x only switches
+ * channel on the STOP that ends the write to it, so every control register
+ * write is a transfer of its own, never joined by a repeated start to the
+ * access behind it. Called with the bus lock held. */
+static int mux_select(struct pi3g_bus *bus, const struct pi3g_intf *intf)
+{
+    struct i2c_msg msgs[PI3G_MUX_N];
+    uint8_t ctrl[PI3G_MUX_N];
+    uint8_t n = mux_route(bus, intf, msgs, ctrl);
+    int ok;
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if (intf->i2c_mode == PI3G_I2C_MODE_RDWR)
+        {
+            struct i2c_rdwr_ioctl_data xfer = {.msgs = &msgs[i], .nmsgs = 1};
+
+            ok = (ioctl(bus->fd, I2C_RDWR, &xfer) == 1);
+        }
+        else
+        {
+            ok = (set_slave_addr(bus, msgs[i].addr) == 0 && write(bus->fd, msgs[i].buf, 1) == 1);
+        }
+        if (!ok)
+        {
+            perror("mux select");
+            mux_invalidate(bus);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+uint16_t
+get_max(uint16_t array[], int8_t len)
+{
+    uint16_t max = 0;
+    for (int i = 0; i < (ssize_t)len; i++)
+    {
+        if (array[i] > max)
+        {
+            max = array[i];
+        }
+    }
+    return max;
+}
+
+static int64_t real_now_ns(void)
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+
+    int64_t time_ns = (int64_t)(spec.tv_sec) * (int64_t)1000000000 + (int64_t)(spec.tv_nsec);
+    return time_ns;
+}
+
+static int real_sleep_until_ns(int64_t deadline_ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = deadline_ns / 1000000000;
+    ts.tv_nsec = deadline_ns % 1000000000;
+
+    return clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/* Virtual time in ns, and the wall clock time it started at */
+static atomic_int_least64_t virtual_ns;
+static atomic_int_least64_t virtual_epoch_ns;
+
+static int64_t virtual_now_ns(void)
+{
+    return atomic_load(&virtual_ns);
+}
+
+/* Returns at once with the clock moved on to deadline_ns. With several
+ * threads the clock follows whoever sleeps first, only a single thread
+ * gets a deterministic timeline. */
+static int virtual_sleep_until_ns(int64_t deadline_ns)
+{
+    int64_t now_ns = atomic_load(&virtual_ns);
+
+    while (now_ns < deadline_ns && !atomic_compare_exchange_weak(&virtual_ns, &now_ns, deadline_ns))
+    {
+    }
+    return 0;
+}
+
+static const struct pi3g_clock clocks[] = {
+    {"real", real_now_ns, real_sleep_until_ns},
+    {"virtual", virtual_now_ns, virtual_sleep_until_ns},
+};
+
+static _Atomic(const struct pi3g_clock *) active_clock = &clocks[0];
+
+/* Switch the clock of all sensors. The virtual clock starts at start_ns,
+ * or where the clock in use is now if start_ns is negative, so next_call
+ * deadlines stay valid across the switch. Returns -1 for an unknown name
+ * and -2 while the virtual clock is ahead of the real one, switching back
+ * would move time backwards and leave the deadlines far in the future.
+ * Switch while no acquisition runs, sleeps in progress keep their clock. */
+int8_t pi3g_set_clock(const char *name, int64_t start_ns)
+{
+    for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++)
+    {
+        if (strcmp(clocks[i].name, name) == 0)
+        {
+            if (clocks[i].now_ns == real_now_ns && atomic_load(&active_clock)->now_ns == virtual_now_ns && virtual_now_ns() > real_now_ns())
+            {
+                return -2;
+            }
+            if (clocks[i].now_ns == virtual_now_ns)
+            {
+                struct timespec wall;
+
+                if (start_ns < 0)
+                {
+                    start_ns = pi3g_timestamp_ns();
+                }
+                clock_gettime(CLOCK_REALTIME, &wall);
+                atomic_store(&virtual_epoch_ns, (int64_t)wall.tv_sec * 1000000000 + wall.tv_nsec - start_ns);
+                atomic_store(&virtual_ns, start_ns);
+            }
+            atomic_store(&active_clock, &clocks[i]);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+const char *pi3g_clock_name()
+{
+    return atomic_load(&active_clock)->name;
+}
+
+uint8_t pi3g_clock_is_virtual()
+{
+    return atomic_load(&active_clock)->now_ns == virtual_now_ns;
+}
+
+/* Move the virtual clock on by duration_ns without sleeping, returns the
+ * new time. A no-op on the real clock. */
+int64_t pi3g_clock_advance_ns(int64_t duration_ns)
+{
+    if (pi3g_clock_is_virtual() && duration_ns > 0)
+    {
+        return atomic_fetch_add(&virtual_ns, duration_ns) + duration_ns;
+    }
+    return pi3g_timestamp_ns();
+}
+
+/* Wall clock time in s, time(NULL) that runs with the virtual clock */
+time_t pi3g_clock_wall_s()
+{
+    if (pi3g_clock_is_virtual())
+    {
+        return (time_t)((atomic_load(&virtual_epoch_ns) + atomic_load(&virtual_ns)) / 1000000000);
+    }
+    return time(NULL);
+}
+
+/* Sleep for duration_us. If the sensor has a spin margin set (real-time
+ * acquisition), sleep to within the margin and spin the rest, so the
+ * scheduler's wake-up latency does not add to the delay. */
+void pi3g_delay_us(uint32_t duration_us, void *intf_ptr)
+{
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+
+    if (intf != NULL && intf->spin_ns > 0)
+    {
+        int64_t deadline_ns = pi3g_timestamp_ns() + (int64_t)duration_us * 1000;
+
+        if ((int64_t)duration_us * 1000 > intf->spin_ns)
+        {
+            (void)pi3g_sleep_until_ns(deadline_ns - intf->spin_ns);
+        }
+        (void)pi3g_spin_until_ns(deadline_ns);
+        return;
+    }
+
+    (void)pi3g_sleep_until_ns(pi3g_timestamp_ns() + (int64_t)duration_us * 1000);
+}
+
+/* Sleep until deadline_ns on the pi3g_timestamp_ns() clock. An absolute
+ * deadline does not drift with wake-up latency. Returns 0, or EINTR if a
+ * signal cut the sleep short. */
+int pi3g_sleep_until_ns(int64_t deadline_ns)
+{
+    if (deadline_ns <= 0)
+    {
+        return 0;
+    }
+    return atomic_load(&active_clock)->sleep_until_ns(deadline_ns);
+}
+
+/* Busy-wait until deadline_ns, returns the time it got there. The virtual
+ * clock only moves when someone sleeps, so spinning on it just jumps. */
+int64_t pi3g_spin_until_ns(int64_t deadline_ns)
+{
+    int64_t now_ns;
+
+    if (pi3g_clock_is_virtual())
+    {
+        (void)pi3g_sleep_until_ns(deadline_ns);
+    }
+
+    while ((now_ns = pi3g_timestamp_ns()) < deadline_ns)
+    {
+    }
+    return now_ns;
+}
+
+/* Spin margin for the hybrid sleep of the calling thread, from how far a
+ * few short absolute sleeps overshoot. Call it with the thread's final
+ * scheduling policy in place. */
+uint32_t pi3g_calibrate_spin_ns()
+{
+    int64_t max_ns = 0;
+
+    for (int i = 0; i < PI3G_SPIN_N_PROBES; i++)
+    {
+        int64_t deadline_ns = pi3g_timestamp_ns() + 1000000;
+        int64_t over_ns;
+
+        (void)pi3g_sleep_until_ns(deadline_ns);
+        over_ns = pi3g_timestamp_ns() - deadline_ns;
+        if (over_ns > max_ns)
+        {
+            max_ns = over_ns;
+        }
+    }
+    max_ns *= PI3G_SPIN_FACTOR;
+
+    return (max_ns > PI3G_SPIN_MAX_NS) ? PI3G_SPIN_MAX_NS : (uint32_t)max_ns;
+}
+
+/* Log2 histogram bucket of a duration in ns, see PI3G_STATS_N_BUCKETS */
+static uint8_t stats_bucket(int64_t ns)
+{
+    int64_t us = ns / 1000;
+    uint8_t bucket = 0;
+
+    while (us > 1 && bucket < PI3G_STATS_N_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void pi3g_wake_stats_add(struct pi3g_wake_stats *stats, int64_t err_ns)
+{
+    stats->wakeups++;
+    stats->err_sum_ns += err_ns;
+    if (err_ns > stats->err_max_ns)
+    {
+        stats->err_max_ns = err_ns;
+    }
+    stats->err_hist[stats_bucket(err_ns)]++;
+}
+
+/* Voluntary context switches of the calling thread */
+static uint64_t thread_wakeups()
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_THREAD, &usage) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)usage.ru_nvcsw;
+}
+
+/* Start counting the wake-ups of the calling thread */
+void pi3g_wake_stats_start(struct pi3g_wake_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->start_ns = pi3g_timestamp_ns();
+    stats->last_ns = stats->start_ns;
+    stats->thread_wakeups_base = thread_wakeups();
+}
+
+/* Catch up the wake-up count, called on the thread of
+ * pi3g_wake_stats_start */
+void pi3g_wake_stats_update(struct pi3g_wake_stats *stats)
+{
+    stats->last_ns = pi3g_timestamp_ns();
+    stats->thread_wakeups = thread_wakeups() - stats->thread_wakeups_base;
+}
+
+/* Timer slack of the calling thread, how late the kernel may fire its
+ * timers to batch wake-ups. 0 restores the default. Ignored for
+ * real-time threads. Returns 0 or an errno. */
+int pi3g_set_timer_slack_ns(uint64_t slack_ns)
+{
+    return (prctl(PR_SET_TIMERSLACK, (unsigned long)slack_ns, 0, 0, 0) == 0) ? 0 : errno;
+}
+
+/* Thread attributes for a SCHED_FIFO thread of the given priority, pinned
+ * to cpu unless it is negative. A priority of 0 keeps the default policy.
+ * Returns 0 or an errno, pthread_create() fails with EPERM if the process
+ * may not use real-time scheduling. */
+int pi3g_rt_thread_attr(pthread_attr_t *attr, int priority, int cpu)
+{
+    int ret = 0;
+
+    if (priority > 0)
+    {
+        struct sched_param param = {.sched_priority = priority};
+
+        if (priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO))
+        {
+            return EINVAL;
+        }
+        ret = pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        if (ret == 0)
+        {
+            ret = pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+        }
+        if (ret == 0)
+        {
+            ret = pthread_attr_setschedparam(attr, &param);
+        }
+    }
+    if (ret == 0 && cpu >= 0)
+    {
+        cpu_set_t cpus;
+
+        if (cpu >= CPU_SETSIZE)
+        {
+            return EINVAL;
+        }
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        ret = pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus);
+    }
+    return ret;
+}
+
+/* Lock all current and future pages of the process in memory, new
+ * mappings such as thread stacks are then faulted in when they are
+ * created, not on first use. Returns 0 or an errno. */
+int pi3g_rt_lock_memory()
+{
+    return (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) ? 0 : errno;
+}
+
+/* Add an entry to a deadline heap of *n entries, the caller makes sure it
+ * has room for one more */
+void pi3g_heap_push(struct pi3g_deadline *heap, size_t *n, int64_t deadline_ns, uint32_t id)
+{
+    size_t i = (*n)++;
+
+    while (i > 0 && heap[(i - 1) / 2].deadline_ns > deadline_ns)
+    {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i].deadline_ns = deadline_ns;
+    heap[i].id = id;
+}
+
+/* Remove and return the earliest entry of a non-empty deadline heap */
+struct pi3g_deadline pi3g_heap_pop(struct pi3g_deadline *heap, size_t *n)
+{
+    struct pi3g_deadline top = heap[0];
+    struct pi3g_deadline last = heap[--(*n)];
+    size_t i = 0;
+    size_t child;
+
+    while ((child = 2 * i + 1) < *n)
+    {
+        if (child + 1 < *n && heap[child + 1].deadline_ns < heap[child].deadline_ns)
+        {
+            child++;
+        }
+        if (last.deadline_ns <= heap[child].deadline_ns)
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+
+    return top;
+}
+
+/* Register read on the calling thread */
+static int8_t i2c_read_direct(uint8_t regAddr, uint8_t *regData, uint32_t len, struct pi3g_intf *intf)
+{
+    int8_t ret = BME69X_OK;
+    struct pi3g_bus *bus = intf->bus;
+    struct i2c_msg msgs[2];
+
+    pi3g_bus_lock(bus);
+    if (mux_select(bus, intf) < 0)
+    {
+        ret = -1;
+    }
+    else if (intf->i2c_mode == PI3G_I2C_MODE_RDWR)
+    {
+        /* Register address write and data read joined by a repeated start */
+        struct i2c_rdwr_ioctl_data xfer = {.msgs = msgs, .nmsgs = 2};
+
+        msgs[0] = (struct i2c_msg){.addr = intf->i2c_addr, .flags = 0, .len = 1, .buf = &regAddr};
+        msgs[1] = (struct i2c_msg){.addr = intf->i2c_addr, .flags = I2C_M_RD, .len = (uint16_t)len, .buf = regData};
+        if (ioctl(bus->fd, I2C_RDWR, &xfer) != 2)
+        {
+            perror("pi3g_read I2C_RDWR");
+            ret = -1;
+        }
+    }
+    else
+    {
+        if (set_slave_addr(bus, intf->i2c_addr) < 0)
+        {
+            ret = -1;
+        }
+        else if (write(bus->fd, &regAddr, 1) != 1)
+        {
+            perror("pi3g_read register");
+            ret = -1;
+        }
+        if (ret == BME69X_OK && read(bus->fd, regData, len) != (ssize_t)len)
+        {
+            perror("pi3g_read data");
+            ret = -1;
+        }
+    }
+    pi3g_bus_unlock(bus);
+
+    return ret;
+}
+
+/* Register write on the calling thread */
+static int8_t i2c_write_direct(uint8_t regAddr, const uint8_t *regData, uint32_t len, struct pi3g_intf *intf)
+{
+    int8_t ret = BME69X_OK;
+    struct pi3g_bus *bus = intf->bus;
+    uint8_t reg[len + 1];
+    reg[0] = regAddr;
+
+    for (uint32_t i = 1; i < len + 1; i++)
+        reg[i] = regData[i - 1];
+
+    pi3g_bus_lock(bus);
+    if (mux_select(bus, intf) < 0)
+    {
+        ret = -1;
+    }
+    else if (intf->i2c_mode == PI3G_I2C_MODE_RDWR)
+    {
+        /* Address the sensor in the message itself, the fd is shared */
+        struct i2c_msg msg = {.addr = intf->i2c_addr, .flags = 0, .len = (uint16_t)(len + 1), .buf = reg};
+        struct i2c_rdwr_ioctl_data xfer = {.msgs = &msg, .nmsgs = 1};
+
+        if (ioctl(bus->fd, I2C_RDWR, &xfer) != 1)
+        {
+            perror("pi3g_write I2C_RDWR");
+            ret = -1;
+        }
+    }
+    else if (set_slave_addr(bus, intf->i2c_addr) < 0 || write(bus->fd, reg, len + 1) != (ssize_t)(len + 1))
+    {
+        perror("pi3g_write");
+        ret = -1;
+    }
+    pi3g_bus_unlock(bus);
+
+    return ret;
+}
+
+/* Account one transfer of len bytes that started at t0_ns */
+static void stats_add(struct pi3g_stats *stats, uint8_t op, uint32_t len, int8_t ret, int64_t t0_ns)
+{
+    uint64_t dur_ns = (uint64_t)(pi3g_timestamp_ns() - t0_ns);
+
+    if (op == PI3G_IO_READ)
+    {
+        stats->reads++;
+        if (ret == BME69X_OK)
+        {
+            stats->bytes_read += len;
+        }
+    }
+    else
+    {
+        stats->writes++;
+        if (ret == BME69X_OK)
+        {
+            stats->bytes_written += len;
+        }
+    }
+    if (ret != BME69X_OK)
+    {
+        stats->failures++;
+    }
+    stats->time_ns += dur_ns;
+    if (dur_ns > stats->max_ns)
+    {
+        stats->max_ns = dur_ns;
+    }
+    stats->latency_hist[stats_bucket((int64_t)dur_ns)]++;
+}
+
+void pi3g_stats_reset(struct pi3g_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+/* Transfer times include the wait for the bus lock */
+int8_t pi3g_read(uint8_t regAddr, uint8_t *regData, uint32_t len, void *intf_ptr)
+{
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+    int64_t t0_ns = pi3g_timestamp_ns();
+    int8_t ret;
+
+    if (intf->bus == NULL)
+    {
+        return -1;
+    }
+
+    ret = i2c_read_direct(regAddr, regData, len, intf);
+    stats_add(&intf->stats, PI3G_IO_READ, len, ret, t0_ns);
+
+    return ret;
+}
+
+int8_t pi3g_write(uint8_t regAddr, const uint8_t *regData, uint32_t len, void *intf_ptr)
+{
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+    int64_t t0_ns = pi3g_timestamp_ns();
+    int8_t ret;
+
+    if (intf->bus == NULL)
+    {
+        return -1;
+    }
+
+    ret = i2c_write_direct(regAddr, regData, len, intf);
+    stats_add(&intf->stats, PI3G_IO_WRITE, len, ret, t0_ns);
+
+    return ret;
+}
+
+/* Read several register blocks of one sensor in a single I2C_RDWR
+ * transaction (address write plus data read per block). The transfer runs
+ * under the bus lock. */
+int8_t pi3g_readv(const struct bme69x_read_seg *segs, uint8_t n_segs, void *intf_ptr)
+{
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+    struct pi3g_bus *bus = intf->bus;
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    struct i2c_rdwr_ioctl_data xfer;
+    uint8_t regs[I2C_RDWR_IOCTL_MAX_MSGS / 2];
+    uint32_t len = 0;
+    int64_t t0_ns;
+    int8_t ret = BME69X_OK;
+    uint8_t i;
+
+    if (bus == NULL || 2 * n_segs > I2C_RDWR_IOCTL_MAX_MSGS)
+    {
+        return -1;
+    }
+
+    pi3g_bus_lock(bus);
+    if (intf->i2c_mode != PI3G_I2C_MODE_RDWR)
+    {
+        for (i = 0; i < n_segs && ret == BME69X_OK; i++)
+        {
+            ret = pi3g_read(segs[i].reg_addr, segs[i].reg_data, segs[i].len, intf);
+        }
+        pi3g_bus_unlock(bus);
+        return ret;
+    }
+
+    for (i = 0; i < n_segs; i++)
+    {
+        regs[i] = segs[i].reg_addr;
+        msgs[2 * i].addr = intf->i2c_addr;
+        msgs[2 * i].flags = 0;
+        msgs[2 * i].len = 1;
+        msgs[2 * i].buf = &regs[i];
+        msgs[2 * i + 1].addr = intf->i2c_addr;
+        msgs[2 * i + 1].flags = I2C_M_RD;
+        msgs[2 * i + 1].len = (uint16_t)segs[i].len;
+        msgs[2 * i + 1].buf = segs[i].reg_data;
+        len += segs[i].len;
+    }
+
+    xfer.msgs = msgs;
+    xfer.nmsgs = 2 * n_segs;
+    t0_ns = pi3g_timestamp_ns();
+    if (mux_select(bus, intf) < 0)
+    {
+        ret = -1;
+    }
+    else if (ioctl(bus->fd, I2C_RDWR, &xfer) != (int)(2 * n_segs))
+    {
+        perror("pi3g_readv I2C_RDWR");
+        ret = -1;
+    }
+    stats_add(&intf->stats, PI3G_IO_READ, len, ret, t0_ns);
+    pi3g_bus_unlock(bus);
+
+    return ret;
+}
+
+/* Select the transfer mode for pi3g_read/pi3g_write, falling back to
+ * PI3G_I2C_MODE_RW when the adapter cannot do plain I2C (I2C_RDWR) transfers.
+ * Returns the mode that is actually in use. */
+uint8_t pi3g_set_i2c_mode(struct pi3g_intf *intf, uint8_t mode)
+{
+    intf->i2c_mode = PI3G_I2C_MODE_RW;
+    if (mode == PI3G_I2C_MODE_RDWR)
+    {
+        if (intf->bus->funcs & I2C_FUNC_I2C)
+        {
+            intf->i2c_mode = PI3G_I2C_MODE_RDWR;
+        }
+        else
+        {
+            printf("WARNING: I2C adapter lacks I2C_FUNC_I2C, using write/read transfers\n");
+        }
+    }
+
+    return intf->i2c_mode;
+}
+
+/* Return the shared handle of /dev/i2c-<bus_nr>, opening it on first use.
+ * Every successful call must be paired with pi3g_bus_close. */
+struct pi3g_bus *pi3g_bus_open(uint8_t bus_nr)
+{
+    struct pi3g_bus *bus;
+    pthread_mutexattr_t attr;
+    char i2c_path[32];
+
+    pthread_mutex_lock(&bus_list_lock);
+    for (bus = bus_list; bus != NULL; bus = bus->next)
+    {
+        if (bus->bus_nr == bus_nr)
+        {
+            bus->refcount++;
+            pthread_mutex_unlock(&bus_list_lock);
+            return bus;
+        }
+    }
+
+    bus = calloc(1, sizeof(struct pi3g_bus));
+    if (bus == NULL)
+    {
+        pthread_mutex_unlock(&bus_list_lock);
+        return NULL;
+    }
+
+    snprintf(i2c_path, sizeof(i2c_path), "/dev/i2c-%d", bus_nr);
+    bus->fd = open(i2c_path, O_RDWR);
+    if (bus->fd < 0)
+    {
+        perror("pi3g_bus_open");
+        free(bus);
+        pthread_mutex_unlock(&bus_list_lock);
+        return NULL;
+    }
+
+    if (ioctl(bus->fd, I2C_FUNCS, &bus->funcs) < 0)
+    {
+        perror("I2C_FUNCS");
+        bus->funcs = 0;
+    }
+
+    bus->bus_nr = bus_nr;
+    bus->refcount = 1;
+    bus->slave_addr = -1;
+    bus->flock_fd = -1;
+    mux_invalidate(bus);
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&bus->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    bus->next = bus_list;
+    bus_list = bus;
+    pthread_mutex_unlock(&bus_list_lock);
+
+    return bus;
+}
+
+/* Open /dev/i2c-N again for a bus other sensors may still hold, after an
+ * adapter reset left the old fd dead. The new fd takes the place of the old
+ * one under the bus lock, so its number stays the same. The slave address
+ * and the mux channels are forgotten, the next transfers set them again.
+ * Returns 0 on success, -1 with the old fd left in place otherwise. */
+int8_t pi3g_bus_reopen(struct pi3g_bus *bus)
+{
+    char i2c_path[32];
+    int fd;
+
+    snprintf(i2c_path, sizeof(i2c_path), "/dev/i2c-%d", bus->bus_nr);
+    fd = open(i2c_path, O_RDWR);
+    if (fd < 0)
+    {
+        perror("pi3g_bus_reopen");
+        return -1;
+    }
+
+    pi3g_bus_lock(bus);
+    if (dup2(fd, bus->fd) < 0)
+    {
+        perror("pi3g_bus_reopen");
+        pi3g_bus_unlock(bus);
+        close(fd);
+        return -1;
+    }
+    if (ioctl(bus->fd, I2C_FUNCS, &bus->funcs) < 0)
+    {
+        perror("I2C_FUNCS");
+        bus->funcs = 0;
+    }
+    bus->slave_addr = -1;
+    mux_invalidate(bus);
+    pi3g_bus_unlock(bus);
+    close(fd);
+
+    return 0;
+}
+
+/* Drop one reference, closing the bus once the last sensor is gone */
+void pi3g_bus_close(struct pi3g_bus *bus)
+{
+    struct pi3g_bus **link;
+
+    if (bus == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&bus_list_lock);
+    if (--bus->refcount == 0)
+    {
+        for (link = &bus_list; *link != NULL; link = &(*link)->next)
+        {
+            if (*link == bus)
+            {
+                *link = bus->next;
+                break;
+            }
+        }
+        close(bus->fd);
+        if (bus->flock_fd >= 0)
+        {
+            close(bus->flock_fd);
+        }
+        pthread_mutex_destroy(&bus->lock);
+        free(bus);
+    }
+    pthread_mutex_unlock(&bus_list_lock);
+}
+
+/* Take the bus for the calling thread. The outermost call also takes the
+ * lock file, if enabled, so a group of transfers cannot interleave with
+ * other processes on the bus. */
+void pi3g_bus_lock(struct pi3g_bus *bus)
+{
+    struct pi3g_lock_stats *stats = &bus->lock_stats;
+    int64_t t0_ns = pi3g_timestamp_ns();
+    uint8_t contended = 0;
+    uint64_t wait_ns;
+
+    if (pthread_mutex_trylock(&bus->lock) != 0)
+    {
+        contended = 1;
+        pthread_mutex_lock(&bus->lock);
+    }
+    if (bus->lock_depth++ > 0)
+    {
+        return;
+    }
+
+    if (bus->flock_fd >= 0)
+    {
+        if (flock(bus->flock_fd, LOCK_EX | LOCK_NB) < 0)
+        {
+            contended = 1;
+            while (flock(bus->flock_fd, LOCK_EX) < 0 && errno == EINTR)
+            {
+            }
+        }
+        /* Other processes may have moved the muxes since we last held it */
+        mux_invalidate(bus);
+    }
+
+    bus->held_since_ns = pi3g_timestamp_ns();
+    wait_ns = (uint64_t)(bus->held_since_ns - t0_ns);
+    stats->acquisitions++;
+    stats->contended += contended;
+    stats->wait_ns += wait_ns;
+    if (wait_ns > stats->max_wait_ns)
+    {
+        stats->max_wait_ns = wait_ns;
+    }
+}
+
+void pi3g_bus_unlock(struct pi3g_bus *bus)
+{
+    struct pi3g_lock_stats *stats = &bus->lock_stats;
+    uint64_t hold_ns;
+
+    if (--bus->lock_depth == 0)
+    {
+        hold_ns = (uint64_t)(pi3g_timestamp_ns() - bus->held_since_ns);
+        stats->hold_ns += hold_ns;
+        if (hold_ns > stats->max_hold_ns)
+        {
+            stats->max_hold_ns = hold_ns;
+        }
+        if (bus->flock_fd >= 0)
+        {
+            flock(bus->flock_fd, LOCK_UN);
+        }
+    }
+    pthread_mutex_unlock(&bus->lock);
+}
+
+/* Arbitrate the bus with other processes through PI3G_BUS_LOCK_PATH.
+ * Returns 0 on success. */
+int8_t pi3g_bus_enable_flock(struct pi3g_bus *bus)
+{
+    char lock_path[32];
+    int fd;
+
+    if (bus->flock_fd >= 0)
+    {
+        return 0;
+    }
+
+    snprintf(lock_path, sizeof(lock_path), PI3G_BUS_LOCK_PATH, bus->bus_nr);
+    fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0)
+    {
+        perror("pi3g_bus_enable_flock");
+        return -1;
+    }
+
+    /* Switch while no group is in flight, it must unlock what it locked */
+    pthread_mutex_lock(&bus->lock);
+    if (bus->lock_depth == 0 && bus->flock_fd < 0)
+    {
+        bus->flock_fd = fd;
+        fd = -1;
+    }
+    pthread_mutex_unlock(&bus->lock);
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return bus->flock_fd >= 0 ? 0 : -1;
+}
+
+void pi3g_bus_get_lock_stats(struct pi3g_bus *bus, struct pi3g_lock_stats *stats)
+{
+    pthread_mutex_lock(&bus->lock);
+    *stats = bus->lock_stats;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+uint64_t pi3g_bus_get_mux_switches(struct pi3g_bus *bus)
+{
+    uint64_t mux_switches;
+
+    pthread_mutex_lock(&bus->lock);
+    mux_switches = bus->mux_switches;
+    pthread_mutex_unlock(&bus->lock);
+
+    return mux_switches;
+}
+
+/* Zero the bus-wide counters, lock contention and mux switches */
+void pi3g_bus_reset_stats(struct pi3g_bus *bus)
+{
+    pthread_mutex_lock(&bus->lock);
+    memset(&bus->lock_stats, 0, sizeof(bus->lock_stats));
+    bus->mux_switches = 0;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+/* Group the following transfers of intf into one bus transaction, a no-op
+ * for transports without a shared bus */
+void pi3g_intf_lock(struct pi3g_intf *intf)
+{
+    if (intf->bus != NULL)
+    {
+        pi3g_bus_lock(intf->bus);
+    }
+}
+
+void pi3g_intf_unlock(struct pi3g_intf *intf)
+{
+    if (intf->bus != NULL)
+    {
+        pi3g_bus_unlock(intf->bus);
+    }
+}
+
+static int8_t i2c_open(struct pi3g_intf *intf)
+{
+    uint8_t mux_bit;
+
+    if (intf->mux_addr != 0 &&
+        (intf->mux_addr < PI3G_MUX_ADDR_MIN || intf->mux_addr >= PI3G_MUX_ADDR_MIN + PI3G_MUX_N ||
+         intf->mux_channel >= PI3G_MUX_N_CHANNELS))
+    {
+        return -1;
+    }
+
+    intf->bus = pi3g_bus_open(intf->bus_nr);
+    if (intf->bus == NULL)
+    {
+        return -1;
+    }
+
+    /* Route the transfers of the bus through the mux from now on */
+    if (intf->mux_addr != 0)
+    {
+        mux_bit = (uint8_t)(1u << (intf->mux_addr - PI3G_MUX_ADDR_MIN));
+        pi3g_bus_lock(intf->bus);
+        intf->bus->mux_used |= mux_bit;
+        pi3g_bus_unlock(intf->bus);
+    }
+
+    return 0;
+}
+
+static void i2c_close(struct pi3g_intf *intf)
+{
+    pi3g_bus_close(intf->bus);
+    intf->bus = NULL;
+}
 
-#ifdef BSEC
-/* TVOC equivalent baseline tracker constants */
-#define TVOC_EQUIVALENT_ENABLE    3
-#define TVOC_EQUIVALENT_DISABLE   0
-#define TVOC_CALIBRATION_TIME_SEC (30 * 60)  /* 30 minutes in seconds */
+static int8_t spi_open(struct pi3g_intf *intf)
+{
+    char spi_path[32];
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8;
 
-/* Global variable for baseline tracker */
-static uint8_t baseline_tracker = TVOC_EQUIVALENT_DISABLE;
-/* Global variable to track the current sample rate */
-static float current_sample_rate = 0.0f;
-/* TVOC calibration tracking variables */
-static time_t tvoc_start_time = 0;
-static bool tvoc_disable_flag = false;
-static bool tvoc_calibration_started = false;
-#endif
+    snprintf(spi_path, sizeof(spi_path), "/dev/spidev%d.%d", intf->bus_nr, intf->spi_cs);
+    intf->spi_fd = open(spi_path, O_RDWR);
+    if (intf->spi_fd < 0)
+    {
+        perror("spi_open");
+        return -1;
+    }
 
-uint16_t
-get_max(uint16_t array[], int8_t len)
+    if (ioctl(intf->spi_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(intf->spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(intf->spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &intf->spi_speed_hz) < 0)
+    {
+        perror("spi_open setup");
+        close(intf->spi_fd);
+        intf->spi_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static void spi_close(struct pi3g_intf *intf)
 {
-    uint16_t max = 0;
-    for (int i = 0; i < (ssize_t)len; i++)
+    if (intf->spi_fd >= 0)
     {
-        if (array[i] > max)
+        close(intf->spi_fd);
+    }
+    intf->spi_fd = -1;
+}
+
+/* Power-on state of the emulated sensor */
+static void fake_reset(struct pi3g_fake *fake)
+{
+    memset(fake->regs, 0, sizeof(fake->regs));
+    fake->regs[BME69X_REG_CHIP_ID] = BME69X_CHIP_ID;
+    fake->regs[BME69X_REG_VARIANT_ID] = BME690_VARIANT_GAS_HIGH;
+    fake->meas_index = 0;
+}
+
+/* Fill n_fields data fields as if a measurement just completed */
+static void fake_measure(struct pi3g_fake *fake, uint8_t n_fields)
+{
+    uint8_t *field;
+
+    for (uint8_t i = 0; i < n_fields; i++)
+    {
+        field = &fake->regs[BME69X_REG_FIELD0 + i * BME69X_LEN_FIELD_OFFSET];
+        memset(field, 0, BME69X_LEN_FIELD);
+        field[0] = BME69X_NEW_DATA_MSK | (i & BME69X_GAS_INDEX_MSK);
+        /* A forced measurement has no sub-measurements, index 0 */
+        field[1] = (n_fields > 1) ? fake->meas_index++ : 0;
+        field[2] = 0x50; /* pressure */
+        field[5] = 0x80; /* temperature */
+        field[8] = 0x60; /* humidity */
+        field[15] = 0x80; /* gas */
+        field[16] = BME69X_GASM_VALID_MSK | BME69X_HEAT_STAB_MSK | 0x04;
+    }
+}
+
+/* Map a 7 bit SPI address to the I2C address space through the memory page */
+static uint8_t fake_addr(const struct pi3g_fake *fake, uint8_t spi_addr)
+{
+    spi_addr &= BME69X_SPI_WR_MSK;
+    if (spi_addr == (BME69X_REG_MEM_PAGE & BME69X_SPI_WR_MSK))
+    {
+        return spi_addr;
+    }
+
+    return (fake->regs[BME69X_REG_MEM_PAGE & BME69X_SPI_WR_MSK] & BME69X_MEM_PAGE_MSK) ? spi_addr : (spi_addr | 0x80);
+}
+
+static void fake_write_reg(struct pi3g_fake *fake, uint8_t spi_addr, uint8_t value)
+{
+    uint8_t addr = fake_addr(fake, spi_addr);
+
+    if (addr == BME69X_REG_SOFT_RESET)
+    {
+        if (value == BME69X_SOFT_RESET_CMD)
         {
-            max = array[i];
+            fake_reset(fake);
+        }
+        return;
+    }
+
+    fake->regs[addr] = value;
+    if (addr == BME69X_REG_CTRL_MEAS)
+    {
+        switch (value & BME69X_MODE_MSK)
+        {
+        case BME69X_FORCED_MODE:
+            /* Measurement done at once, back to sleep */
+            fake_measure(fake, 1);
+            fake->regs[addr] &= (uint8_t)~BME69X_MODE_MSK;
+            break;
+        case BME69X_PARALLEL_MODE:
+        case BME69X_SEQUENTIAL_MODE:
+            fake_measure(fake, 3);
+            break;
+        default:
+            break;
         }
     }
-    return max;
 }
 
-void pi3g_delay_us(uint32_t duration_us, void *intf_ptr)
+/* Full-duplex transfer against the emulated sensor, same framing as the
+ * BME69X SPI interface: bit 7 of the first byte selects a read with auto
+ * increment, writes are address/data pairs */
+static void fake_xfer(struct pi3g_fake *fake, const uint8_t *tx, uint8_t *rx, uint32_t len)
 {
-    struct timespec ts;
-    ts.tv_sec = duration_us / 1000000;
-    ts.tv_nsec = (duration_us % 1000000) * 1000;
-    nanosleep(&ts, NULL);
+    uint8_t addr;
+
+    memset(rx, 0, len);
+    if (tx[0] & BME69X_SPI_RD_MSK)
+    {
+        addr = tx[0] & BME69X_SPI_WR_MSK;
+        for (uint32_t i = 1; i < len; i++)
+        {
+            rx[i] = fake->regs[fake_addr(fake, addr)];
+            addr = (addr + 1) & BME69X_SPI_WR_MSK;
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i + 1 < len; i += 2)
+        {
+            fake_write_reg(fake, tx[i], tx[i + 1]);
+        }
+    }
 }
 
-int8_t pi3g_read(uint8_t regAddr, uint8_t *regData, uint32_t len, void *intf_ptr)
+static int8_t fake_open(struct pi3g_intf *intf)
 {
-    rslt = BME69X_OK;
-    int fd = *((int *)intf_ptr);
-    if (write(fd, &regAddr, 1) != 1)
+    intf->fake = calloc(1, sizeof(struct pi3g_fake));
+    if (intf->fake == NULL)
     {
-        perror("pi3g_read register");
-        rslt = -1;
+        return -1;
     }
-    if (read(fd, regData, len) != (ssize_t)len)
+    fake_reset(intf->fake);
+
+    return 0;
+}
+
+static void fake_close(struct pi3g_intf *intf)
+{
+    free(intf->fake);
+    intf->fake = NULL;
+}
+
+/* One full-duplex transfer of len bytes, to the fake sensor if there is one */
+static int8_t spi_xfer(struct pi3g_intf *intf, const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    struct spi_ioc_transfer tr;
+
+    if (intf->fake)
     {
-        perror("pi3g_read data");
-        rslt = -1;
+        fake_xfer(intf->fake, tx, rx, len);
+        return BME69X_OK;
     }
 
-    return rslt;
+    if (intf->spi_fd < 0)
+    {
+        return -1;
+    }
+
+    memset(&tr, 0, sizeof(tr));
+    tr.tx_buf = (unsigned long)tx;
+    tr.rx_buf = (unsigned long)rx;
+    tr.len = len;
+    tr.speed_hz = intf->spi_speed_hz;
+    tr.bits_per_word = 8;
+    if (ioctl(intf->spi_fd, SPI_IOC_MESSAGE(1), &tr) != (int)len)
+    {
+        perror("spi_xfer");
+        return -1;
+    }
+
+    return BME69X_OK;
 }
 
-int8_t pi3g_write(uint8_t regAddr, const uint8_t *regData, uint32_t len, void *intf_ptr)
+/* The driver already sets the read bit and selects the memory page, the
+ * address byte goes out as is and the data is clocked in behind it */
+int8_t pi3g_spi_read(uint8_t regAddr, uint8_t *regData, uint32_t len, void *intf_ptr)
 {
-    rslt = BME69X_OK;
-    int fd = *((int *)intf_ptr);
-    uint8_t reg[len + 1];
-    reg[0] = regAddr;
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+    uint8_t tx[len + 1];
+    uint8_t rx[len + 1];
+    int64_t t0_ns = pi3g_timestamp_ns();
+    int8_t ret;
 
-    for (uint32_t i = 1; i < len + 1; i++)
-        reg[i] = regData[i - 1];
+    memset(tx, 0, len + 1);
+    tx[0] = regAddr;
+    ret = spi_xfer(intf, tx, rx, len + 1);
+    if (ret == BME69X_OK)
+    {
+        memcpy(regData, &rx[1], len);
+    }
+    stats_add(&intf->stats, PI3G_IO_READ, len, ret, t0_ns);
+
+    return ret;
+}
+
+int8_t pi3g_spi_write(uint8_t regAddr, const uint8_t *regData, uint32_t len, void *intf_ptr)
+{
+    struct pi3g_intf *intf = (struct pi3g_intf *)intf_ptr;
+    uint8_t tx[len + 1];
+    uint8_t rx[len + 1];
+    int64_t t0_ns = pi3g_timestamp_ns();
+    int8_t ret;
 
-    if (write(fd, reg, len + 1) != (ssize_t)(len + 1))
+    tx[0] = regAddr;
+    memcpy(&tx[1], regData, len);
+    ret = spi_xfer(intf, tx, rx, len + 1);
+    stats_add(&intf->stats, PI3G_IO_WRITE, len, ret, t0_ns);
+
+    return ret;
+}
+
+static const struct pi3g_transport transports[] = {
+    {"i2c", PI3G_TRANSPORT_I2C, BME69X_I2C_INTF, i2c_open, i2c_close, pi3g_read, pi3g_write, pi3g_readv},
+    {"spi", PI3G_TRANSPORT_SPI, BME69X_SPI_INTF, spi_open, spi_close, pi3g_spi_read, pi3g_spi_write, NULL},
+    {"fake", PI3G_TRANSPORT_FAKE, BME69X_SPI_INTF, fake_open, fake_close, pi3g_spi_read, pi3g_spi_write, NULL},
+};
+
+/* Look up a transport by name, NULL if there is none */
+const struct pi3g_transport *pi3g_get_transport(const char *name)
+{
+    for (size_t i = 0; i < sizeof(transports) / sizeof(transports[0]); i++)
     {
-        perror("pi3g_write");
-        rslt = -1;
+        if (strcmp(transports[i].name, name) == 0)
+        {
+            return &transports[i];
+        }
     }
 
-    return rslt;
+    return NULL;
+}
+
+/* Acquire the device of intf->transport, intf->bus_nr and the transport
+ * specific fields have to be set. Returns 0 on success. */
+int8_t pi3g_intf_open(struct pi3g_intf *intf)
+{
+    if (intf->transport == NULL)
+    {
+        return -1;
+    }
+
+    return intf->transport->open(intf);
+}
+
+void pi3g_intf_close(struct pi3g_intf *intf)
+{
+    if (intf->transport != NULL && pi3g_intf_is_open(intf))
+    {
+        intf->transport->close(intf);
+    }
+}
+
+uint8_t pi3g_intf_is_open(const struct pi3g_intf *intf)
+{
+    return intf->bus != NULL || intf->spi_fd >= 0 || intf->fake != NULL;
+}
+
+/* Linux file descriptor behind intf, -1 if there is none */
+int pi3g_intf_fd(const struct pi3g_intf *intf)
+{
+    if (intf->bus != NULL)
+    {
+        return intf->bus->fd;
+    }
+
+    return intf->spi_fd;
+}
+
+/* Fill order with the indices of intfs sorted by bus, mux and mux channel,
+ * so work for several sensors needs one channel switch per channel */
+void pi3g_mux_order(struct pi3g_intf *intfs[], uint8_t n_intfs, uint8_t *order)
+{
+    uint8_t i, j, k;
+
+    for (i = 0; i < n_intfs; i++)
+    {
+        k = i;
+        for (j = i; j > 0; j--)
+        {
+            const struct pi3g_intf *a = intfs[order[j - 1]];
+            const struct pi3g_intf *b = intfs[k];
+            if ((uintptr_t)a->bus < (uintptr_t)b->bus ||
+                (a->bus == b->bus && (a->mux_addr < b->mux_addr ||
+                                      (a->mux_addr == b->mux_addr && a->mux_channel <= b->mux_channel))))
+            {
+                break;
+            }
+            order[j] = order[j - 1];
+        }
+        order[j] = k;
+    }
+}
+
+/* Read the BME69X_REG_FIELD0 burst of several sensors on the same bus.
+ * With I2C_RDWR the sensors of one mux channel are covered by one ioctl
+ * (address write plus data read per sensor, split only at
+ * I2C_RDWR_IOCTL_MAX_MSGS), preceded by the mux writes of the channel as
+ * transfers of their own. Without I2C_RDWR, or when the combined transfer
+ * fails, every sensor is read on its own so one absent sensor does not
+ * spoil the others. The result of each sensor goes to rslts[i]; returns
+ * BME69X_OK if all of them succeeded, else -1. */
+int8_t pi3g_bus_read_fields(struct pi3g_intf *intfs[], uint8_t n_intfs, uint8_t (*buffs)[BME69X_LEN_FIELD], int8_t *rslts)
+{
+    int8_t ret = BME69X_OK;
+    struct pi3g_bus *bus;
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    struct i2c_rdwr_ioctl_data xfer;
+    uint8_t field_reg = BME69X_REG_FIELD0;
+    const struct pi3g_intf *first;
+    uint8_t i = 0, j, k, n, n_msgs;
+    int64_t t0_ns;
+
+    if (n_intfs == 0)
+    {
+        return BME69X_OK;
+    }
+
+    bus = intfs[0]->bus;
+    if (bus == NULL)
+    {
+        return -1;
+    }
+
+    uint8_t order[n_intfs];
+    pi3g_mux_order(intfs, n_intfs, order);
+
+    pi3g_bus_lock(bus);
+    while (i < n_intfs)
+    {
+        n = 0;
+        first = intfs[order[i]];
+        t0_ns = pi3g_timestamp_ns();
+        if (first->i2c_mode == PI3G_I2C_MODE_RDWR && mux_select(bus, first) == 0)
+        {
+            /* The sensors of the channel that first is on */
+            n_msgs = 0;
+            for (; (i + n < n_intfs) && (intfs[order[i + n]]->i2c_mode == PI3G_I2C_MODE_RDWR) &&
+                   (intfs[order[i + n]]->mux_addr == first->mux_addr) &&
+                   (intfs[order[i + n]]->mux_channel == first->mux_channel) &&
+                   (n_msgs + 2 <= I2C_RDWR_IOCTL_MAX_MSGS); n++)
+            {
+                k = order[i + n];
+                msgs[n_msgs].addr = intfs[k]->i2c_addr;
+                msgs[n_msgs].flags = 0;
+                msgs[n_msgs].len = 1;
+                msgs[n_msgs].buf = &field_reg;
+                msgs[n_msgs + 1].addr = intfs[k]->i2c_addr;
+                msgs[n_msgs + 1].flags = I2C_M_RD;
+                msgs[n_msgs + 1].len = BME69X_LEN_FIELD;
+                msgs[n_msgs + 1].buf = buffs[k];
+                n_msgs += 2;
+            }
+
+            xfer.msgs = msgs;
+            xfer.nmsgs = n_msgs;
+            if (ioctl(bus->fd, I2C_RDWR, &xfer) == (int)n_msgs)
+            {
+                /* Every sensor is charged the time of the whole transfer */
+                for (j = i; j < i + n; j++)
+                {
+                    rslts[order[j]] = BME69X_OK;
+                    stats_add(&intfs[order[j]]->stats, PI3G_IO_READ, BME69X_LEN_FIELD, BME69X_OK, t0_ns);
+                }
+                i += n;
+                continue;
+            }
+        }
+
+        /* Sensor by sensor */
+        for (j = i; j < i + (n ? n : 1); j++)
+        {
+            k = order[j];
+            rslts[k] = pi3g_read(BME69X_REG_FIELD0, buffs[k], BME69X_LEN_FIELD, intfs[k]);
+            if (rslts[k] != BME69X_OK)
+            {
+                ret = -1;
+            }
+        }
+        i = j;
+    }
+    pi3g_bus_unlock(bus);
+
+    return ret;
 }
 
 int8_t pi3g_set_conf(uint8_t os_hum, uint8_t os_pres, uint8_t os_temp, uint8_t filter, uint8_t odr, struct bme69x_conf *conf, struct bme69x_dev *bme, uint8_t debug_mode)
@@ -131,12 +1475,27 @@ int8_t pi3g_set_heater_conf_fm(uint8_t enable, uint16_t heatr_temp, uint16_t hea
     return rslt;
 }
 
+/* The caller's profile arrays may not outlive the call, keep a copy in the
+ * heater config buffers so the profile can be reapplied later */
+static void copy_heater_profile(const uint16_t temp_prof[], const uint16_t dur_prof[], uint8_t profile_len, struct bme69x_heatr_conf *heatr_conf)
+{
+    if (heatr_conf->heatr_temp_prof && heatr_conf->heatr_dur_prof)
+    {
+        memcpy(heatr_conf->heatr_temp_prof, temp_prof, profile_len * sizeof(uint16_t));
+        memcpy(heatr_conf->heatr_dur_prof, dur_prof, profile_len * sizeof(uint16_t));
+    }
+    else
+    {
+        heatr_conf->heatr_temp_prof = (uint16_t *)temp_prof;
+        heatr_conf->heatr_dur_prof = (uint16_t *)dur_prof;
+    }
+}
+
 int8_t pi3g_set_heater_conf_pm(uint8_t enable, uint16_t temp_prof[], uint16_t dur_prof[], uint8_t profile_len, struct bme69x_conf *conf, struct bme69x_heatr_conf *heatr_conf, struct bme69x_dev *bme, uint8_t debug_mode)
 {
     int8_t rslt = BME69X_OK;
     heatr_conf->enable = enable;
-    heatr_conf->heatr_temp_prof = temp_prof;
-    heatr_conf->heatr_dur_prof = dur_prof;
+    copy_heater_profile(temp_prof, dur_prof, profile_len, heatr_conf);
     heatr_conf->shared_heatr_dur = 140 - (bme69x_get_meas_dur(BME69X_PARALLEL_MODE, conf, bme) / 1000);
     heatr_conf->profile_len = profile_len;
     rslt = bme69x_set_heatr_conf(BME69X_PARALLEL_MODE, heatr_conf, bme);
@@ -162,8 +1521,7 @@ int8_t pi3g_set_heater_conf_sm(uint8_t enable, uint16_t temp_prof[], uint16_t du
 {
     int8_t rslt = BME69X_OK;
     heatr_conf->enable = enable;
-    heatr_conf->heatr_temp_prof = temp_prof;
-    heatr_conf->heatr_dur_prof = dur_prof;
+    copy_heater_profile(temp_prof, dur_prof, profile_len, heatr_conf);
     heatr_conf->profile_len = profile_len;
     rslt = bme69x_set_heatr_conf(BME69X_SEQUENTIAL_MODE, heatr_conf, bme);
     if (rslt != BME69X_OK)
@@ -184,11 +1542,7 @@ int8_t pi3g_set_heater_conf_sm(uint8_t enable, uint16_t temp_prof[], uint16_t du
 
 int64_t pi3g_timestamp_ns()
 {
-    struct timespec spec;
-    clock_gettime(CLOCK_MONOTONIC, &spec);
-
-    int64_t time_ns = (int64_t)(spec.tv_sec) * (int64_t)1000000000 + (int64_t)(spec.tv_nsec);
-    return time_ns;
+    return atomic_load(&active_clock)->now_ns();
 }
 
 uint32_t pi3g_timestamp_us()
@@ -205,7 +1559,9 @@ uint32_t pi3g_timestamp_ms()
 bsec_library_return_t bsec_set_sample_rate(void *bme, float sample_rate)
 {
     /* Store the sample rate for later use */
+    pthread_mutex_lock(&tvoc_lock);
     current_sample_rate = sample_rate;
+    pthread_mutex_unlock(&tvoc_lock);
     
     uint8_t n_requested_virtual_sensors;
     n_requested_virtual_sensors = 13;
@@ -403,6 +1759,7 @@ bsec_library_return_t bsec_read_data(struct bme69x_data *data, int64_t time_stam
         }
         /* Baseline tracker for TVOC (only in LP mode) */
         /* Use tolerance for floating-point comparison */
+        pthread_mutex_lock(&tvoc_lock);
         if (fabs(current_sample_rate - BSEC_SAMPLE_RATE_LP) < 0.01f)
         {
             inputs[*n_bsec_inputs].sensor_id = BSEC_INPUT_DISABLE_BASELINE_TRACKER;
@@ -410,6 +1767,7 @@ bsec_library_return_t bsec_read_data(struct bme69x_data *data, int64_t time_stam
             inputs[*n_bsec_inputs].time_stamp = time_stamp;
             (*n_bsec_inputs)++;
         }
+        pthread_mutex_unlock(&tvoc_lock);
     }
     return BSEC_OK;
 }
@@ -528,14 +1886,9 @@ bsec_library_return_t bsec_process_data(void *bme, bsec_input_t *bsec_inputs, ui
  */
 void set_tvoc_equivalent_baseline(bool data)
 {
-    if (data)
-    {
-        baseline_tracker = TVOC_EQUIVALENT_ENABLE;
-    }
-    else
-    {
-        baseline_tracker = TVOC_EQUIVALENT_DISABLE;
-    }
+    pthread_mutex_lock(&tvoc_lock);
+    baseline_tracker = data ? TVOC_EQUIVALENT_ENABLE : TVOC_EQUIVALENT_DISABLE;
+    pthread_mutex_unlock(&tvoc_lock);
 }
 
 /**
@@ -545,6 +1898,8 @@ void set_tvoc_equivalent_baseline(bool data)
  */
 void tvoc_equivalent_calibration()
 {
+    pthread_mutex_lock(&tvoc_lock);
+
     /* Only calibrate in LP mode */
     float sample_rate_diff = fabs(current_sample_rate - BSEC_SAMPLE_RATE_LP);
     printf("[TVOC Calibration] Sample rate: %.5f, LP rate: %.5f, diff: %.5f, test result: %s\n", 
@@ -555,9 +1910,9 @@ void tvoc_equivalent_calibration()
         if (!tvoc_calibration_started)
         {
             /* First call - enable baseline adaptation */
-            set_tvoc_equivalent_baseline(true);
+            baseline_tracker = TVOC_EQUIVALENT_ENABLE;
             tvoc_disable_flag = true;
-            tvoc_start_time = time(NULL);
+            tvoc_start_time = pi3g_clock_wall_s();
             tvoc_calibration_started = true;
             printf("[TVOC] Calibration started at %ld - baseline adaptation enabled for 30 minutes\n", 
                    (long)tvoc_start_time);
@@ -565,13 +1920,13 @@ void tvoc_equivalent_calibration()
         else if (tvoc_disable_flag)
         {
             /* Check if 30 minutes have elapsed */
-            time_t current_time = time(NULL);
+            time_t current_time = pi3g_clock_wall_s();
             time_t elapsed_sec = current_time - tvoc_start_time;
             
             if (elapsed_sec >= TVOC_CALIBRATION_TIME_SEC)
             {
                 /* After 30 minutes - disable baseline adaptation */
-                set_tvoc_equivalent_baseline(false);
+                baseline_tracker = TVOC_EQUIVALENT_DISABLE;
                 tvoc_disable_flag = false;
                 printf("[TVOC] Calibration complete at %ld - baseline adaptation disabled after %ld seconds\n",
                        (long)current_time, (long)elapsed_sec);
@@ -588,6 +1943,8 @@ void tvoc_equivalent_calibration()
         printf("[TVOC] Calibration not supported in current BSEC mode (not LP)\n");
         tvoc_calibration_started = false;
     }
+
+    pthread_mutex_unlock(&tvoc_lock);
 }
 
 /**
@@ -597,6 +1954,180 @@ void tvoc_equivalent_calibration()
  */
 float get_sample_rate_from_bsec()
 {
-    return current_sample_rate;
+    float sample_rate;
+
+    pthread_mutex_lock(&tvoc_lock);
+    sample_rate = current_sample_rate;
+    pthread_mutex_unlock(&tvoc_lock);
+    return sample_rate;
+}
+
+/* Returns -1 if the eventfd cannot be created */
+int8_t pi3g_sample_ring_init(struct pi3g_sample_ring *ring)
+{
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->overruns, 0);
+    atomic_init(&ring->dropped, 0);
+    ring->full = 0;
+    ring->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    return (ring->efd < 0) ? -1 : 0;
+}
+
+void pi3g_sample_ring_close(struct pi3g_sample_ring *ring)
+{
+    if (ring->efd >= 0)
+    {
+        close(ring->efd);
+        ring->efd = -1;
+    }
+}
+
+/* Producer side. Returns -1 and counts the sample as dropped if the ring
+ * is full, the consumer is never blocked by it. */
+int8_t pi3g_sample_ring_push(struct pi3g_sample_ring *ring, const struct pi3g_bsec_sample *sample)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head == PI3G_SAMPLE_RING_DEPTH)
+    {
+        if (!ring->full)
+        {
+            ring->full = 1;
+            atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    ring->full = 0;
+    ring->slots[tail & (PI3G_SAMPLE_RING_DEPTH - 1)] = *sample;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    (void)eventfd_write(ring->efd, 1);
+
+    return 0;
+}
+
+/* Consumer side, copies up to max_n samples oldest first and returns how
+ * many. Clears the eventfd first and signals it again if samples are left,
+ * a push that races with this still signals after it. */
+size_t pi3g_sample_ring_pop(struct pi3g_sample_ring *ring, struct pi3g_bsec_sample *samples, size_t max_n)
+{
+    eventfd_t events;
+    (void)eventfd_read(ring->efd, &events);
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t n = 0;
+
+    while (n < max_n && head != tail)
+    {
+        samples[n++] = ring->slots[head & (PI3G_SAMPLE_RING_DEPTH - 1)];
+        head++;
+    }
+    atomic_store_explicit(&ring->head, head, memory_order_release);
+    if (head != tail)
+    {
+        (void)eventfd_write(ring->efd, 1);
+    }
+
+    return n;
+}
+
+/* Samples waiting in the ring */
+size_t pi3g_sample_ring_count(struct pi3g_sample_ring *ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_acquire) - atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+void pi3g_bsec_timing_reset(struct pi3g_bsec_timing *timing)
+{
+    memset(timing, 0, sizeof(*timing));
+}
+
+/* Account a bsec_sensor_control call at time_stamp that asked for the next
+ * one at next_call. The first call has no deadline to be late for. */
+void pi3g_bsec_timing_call(struct pi3g_bsec_timing *timing, int64_t time_stamp, int64_t next_call)
+{
+    if (timing->calls > 0)
+    {
+        int64_t lateness_ns = time_stamp - timing->next_call_ns;
+
+        if (lateness_ns < 0)
+        {
+            lateness_ns = 0;
+        }
+        timing->lateness_ns = lateness_ns;
+        timing->lateness_sum_ns += lateness_ns;
+        if (lateness_ns > timing->lateness_max_ns)
+        {
+            timing->lateness_max_ns = lateness_ns;
+        }
+        timing->lateness_hist[stats_bucket(lateness_ns)]++;
+    }
+
+    timing->calls++;
+    timing->next_call_ns = next_call;
+    timing->period_ns = next_call - time_stamp;
+}
+
+/* Account a processed sample of the call at time_stamp. The fields of a
+ * parallel or sequential scan share the call, they count once. */
+void pi3g_bsec_timing_sample(struct pi3g_bsec_timing *timing, int64_t time_stamp)
+{
+    if (timing->samples > 0 && time_stamp == timing->sample_ns)
+    {
+        return;
+    }
+
+    if (timing->samples > 0 && timing->sample_period_ns > 0)
+    {
+        int64_t err_ns = (time_stamp - timing->sample_ns) - timing->sample_period_ns;
+        int64_t abs_ns = (err_ns < 0) ? -err_ns : err_ns;
+
+        timing->intervals++;
+        timing->interval_err_sum_ns += err_ns;
+        if (abs_ns > timing->interval_err_max_ns)
+        {
+            timing->interval_err_max_ns = abs_ns;
+        }
+        timing->interval_hist[stats_bucket(abs_ns)]++;
+        if (abs_ns > (timing->sample_period_ns >> PI3G_BSEC_TOLERANCE_SHIFT))
+        {
+            timing->missed++;
+        }
+    }
+
+    timing->samples++;
+    timing->sample_ns = time_stamp;
+    timing->sample_period_ns = timing->period_ns;
+}
+
+/* Count rslt of a BSEC call if it is a warning or an error */
+void pi3g_bsec_timing_result(struct pi3g_bsec_timing *timing, bsec_library_return_t rslt)
+{
+    if (rslt == BSEC_OK)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < timing->n_codes; i++)
+    {
+        if (timing->codes[i] == rslt)
+        {
+            timing->code_counts[i]++;
+            return;
+        }
+    }
+    if (timing->n_codes < PI3G_BSEC_N_CODES)
+    {
+        timing->codes[timing->n_codes] = rslt;
+        timing->code_counts[timing->n_codes] = 1;
+        timing->n_codes++;
+        return;
+    }
+    timing->other_codes++;
 }
 #endif
@@ -15,7 +15,18 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <linux/spi/spidev.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
 #include "BME690_SensorAPI/bme69x.h"
 #include "BME690_SensorAPI/bme69x_defs.h"
 
@@ -26,6 +37,353 @@
 #include "bsec_v3-2-1-0/algo/bsec_IAQ_Sel/inc/bsec_datatypes.h"
 #endif
 
+/* I2C transfer modes used by pi3g_read */
+#define PI3G_I2C_MODE_RW    UINT8_C(0) /* write() the register address, then read() the data */
+#define PI3G_I2C_MODE_RDWR  UINT8_C(1) /* address write and data read in one I2C_RDWR ioctl (repeated start) */
+
+/* Register transports, see pi3g_get_transport */
+#define PI3G_TRANSPORT_I2C  UINT8_C(0) /* /dev/i2c-N, shared through struct pi3g_bus */
+#define PI3G_TRANSPORT_SPI  UINT8_C(1) /* /dev/spidevB.C, full-duplex SPI_IOC_MESSAGE transfers */
+#define PI3G_TRANSPORT_FAKE UINT8_C(2) /* in-process emulation of the BME69X SPI register file */
+
+/* Size of the register file emulated by the fake transport */
+#define PI3G_FAKE_N_REGS    256
+
+/* Transfer directions counted by struct pi3g_stats */
+#define PI3G_IO_READ        UINT8_C(0)
+#define PI3G_IO_WRITE       UINT8_C(1)
+
+/* Advisory lock file of /dev/i2c-N shared with other processes, see
+ * pi3g_bus_enable_flock */
+#define PI3G_BUS_LOCK_PATH  "/run/lock/i2c-%u.lock"
+
+/* TCA9548A/PCA954x I2C multiplexers, addresses 0x70 to 0x77 */
+#define PI3G_MUX_ADDR_MIN   UINT8_C(0x70)
+#define PI3G_MUX_N          8
+#define PI3G_MUX_N_CHANNELS 8
+#define PI3G_MUX_UNKNOWN    -1 /* channel state of a mux after an error */
+
+/* Slots of a sample ring, power of 2 */
+#define PI3G_SAMPLE_RING_DEPTH 128
+
+/* Distinct BSEC return codes counted per sensor, further ones only count
+ * towards other_codes */
+#define PI3G_BSEC_N_CODES 16
+
+/* A sample interval misses its deadline when it is off the requested one by
+ * more than a 16th, BSEC's own tolerance for the call timing */
+#define PI3G_BSEC_TOLERANCE_SHIFT 4
+
+/* Spin margin of the hybrid sleep: measured nanosleep overshoot times
+ * PI3G_SPIN_FACTOR, at most PI3G_SPIN_MAX_NS */
+#define PI3G_SPIN_FACTOR   2
+#define PI3G_SPIN_MAX_NS   2000000
+#define PI3G_SPIN_N_PROBES 20
+
+/* Timer slack of the low-power waits: a 16th of the wait, at most
+ * PI3G_LP_SLACK_MAX_NS */
+#define PI3G_LP_SLACK_SHIFT  4
+#define PI3G_LP_SLACK_MAX_NS 1000000000
+
+/* Latency buckets of struct pi3g_stats, bucket i counts [2^i, 2^(i+1)) us,
+ * the first one everything below 2 us and the last one everything above */
+#define PI3G_STATS_N_BUCKETS 16
+
+/* Contention counters of a bus lock, transfer groups are counted once */
+struct pi3g_lock_stats
+{
+    /* Outermost pi3g_bus_lock calls */
+    uint64_t acquisitions;
+
+    /* Acquisitions that had to wait for another thread or process */
+    uint64_t contended;
+
+    /* Sum and maximum of the waits in ns */
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+
+    /* Sum and maximum of the hold times in ns */
+    uint64_t hold_ns;
+    uint64_t max_hold_ns;
+};
+
+/* One opened /dev/i2c-N, shared by every sensor on that bus */
+struct pi3g_bus
+{
+    /* File descriptor of /dev/i2c-N */
+    int fd;
+
+    /* Bus number N */
+    uint8_t bus_nr;
+
+    /* Number of sensors holding this bus */
+    uint32_t refcount;
+
+    /* Adapter functionality mask (I2C_FUNCS) */
+    unsigned long funcs;
+
+    /* Address last set with I2C_SLAVE, only used by PI3G_I2C_MODE_RW */
+    int16_t slave_addr;
+
+    /* Serializes transactions of all sensors on this bus (recursive, so a
+     * holder can group several transfers) */
+    pthread_mutex_t lock;
+
+    /* Nesting depth of lock, only touched by its holder */
+    uint32_t lock_depth;
+
+    /* Lock file flock()ed by the outermost holder, -1 if disabled */
+    int flock_fd;
+
+    /* Start of the current outermost hold */
+    int64_t held_since_ns;
+
+    /* Protected by lock */
+    struct pi3g_lock_stats lock_stats;
+
+    /* Bit n set if a sensor sits behind the mux at PI3G_MUX_ADDR_MIN + n */
+    uint8_t mux_used;
+
+    /* Control register of each mux as last written, PI3G_MUX_UNKNOWN if not known */
+    int16_t mux_ctrl[PI3G_MUX_N];
+
+    /* Control register writes, protected by lock */
+    uint64_t mux_switches;
+
+    /* Next entry in the list of open buses */
+    struct pi3g_bus *next;
+};
+
+/* Time source of pi3g_timestamp_ns() and all the sleeps, selected by name
+ * with pi3g_set_clock() */
+struct pi3g_clock
+{
+    /* Name used to select the clock */
+    const char *name;
+
+    /* Current time in ns */
+    int64_t (*now_ns)(void);
+
+    /* Sleep until the absolute deadline, 0 or EINTR */
+    int (*sleep_until_ns)(int64_t deadline_ns);
+};
+
+struct pi3g_intf;
+
+/* Transport backend, the read/write pair is handed to the BME69X driver */
+struct pi3g_transport
+{
+    /* Name used to select the transport */
+    const char *name;
+
+    /* PI3G_TRANSPORT_* */
+    uint8_t id;
+
+    /* Register addressing the driver has to use */
+    enum bme69x_intf intf;
+
+    /* Acquire and release the device, 0 on success */
+    int8_t (*open)(struct pi3g_intf *intf);
+    void (*close)(struct pi3g_intf *intf);
+
+    bme69x_read_fptr_t read;
+    bme69x_write_fptr_t write;
+
+    /* Several register blocks in one transaction, NULL if not supported */
+    bme69x_readv_fptr_t readv;
+};
+
+/* State of the emulated sensor behind PI3G_TRANSPORT_FAKE */
+struct pi3g_fake
+{
+    /* Register file by I2C address, 0x73 holds the SPI memory page bit */
+    uint8_t regs[PI3G_FAKE_N_REGS];
+
+    /* Counter for the meas_index of the emulated fields */
+    uint8_t meas_index;
+};
+
+/* Transfer counters of one sensor, updated by every register transfer */
+struct pi3g_stats
+{
+    /* Transfers, including failed ones */
+    uint64_t reads;
+    uint64_t writes;
+
+    /* Register bytes moved by successful transfers */
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+
+    /* Transfers that returned an error */
+    uint64_t failures;
+
+    /* Sum and maximum of the transfer times in ns */
+    uint64_t time_ns;
+    uint64_t max_ns;
+
+    /* Log2 histogram of the transfer times in us */
+    uint64_t latency_hist[PI3G_STATS_N_BUCKETS];
+};
+
+/* Wake-up error of the deadline waits of an acquisition thread, how late
+ * it woke up compared to the deadline it slept for */
+struct pi3g_wake_stats
+{
+    uint64_t wakeups;
+
+    /* Sum and maximum of the wake-up errors in ns */
+    int64_t err_sum_ns;
+    int64_t err_max_ns;
+
+    /* Log2 histogram of the wake-up errors in us */
+    uint64_t err_hist[PI3G_STATS_N_BUCKETS];
+
+    /* Voluntary context switches of the thread between start_ns and
+     * last_ns, every sleep and blocking transfer counts */
+    int64_t start_ns;
+    int64_t last_ns;
+    uint64_t thread_wakeups;
+
+    /* Context switch count of the thread at start_ns */
+    uint64_t thread_wakeups_base;
+};
+
+/* Interface descriptor handed to the driver as intf_ptr */
+struct pi3g_intf
+{
+    /* Backend in use */
+    const struct pi3g_transport *transport;
+
+    /* Bus number, /dev/i2c-N or /dev/spidevN.x */
+    uint8_t bus_nr;
+
+    /* Shared bus the sensor sits on (I2C) */
+    struct pi3g_bus *bus;
+
+    /* 7 bit I2C address of the sensor */
+    uint8_t i2c_addr;
+
+    /* Active transfer mode, PI3G_I2C_MODE_RW or PI3G_I2C_MODE_RDWR */
+    uint8_t i2c_mode;
+
+    /* Multiplexer the sensor sits behind (I2C), 0 if it is on the bus itself */
+    uint8_t mux_addr;
+
+    /* Channel of the multiplexer, 0 to PI3G_MUX_N_CHANNELS - 1 */
+    uint8_t mux_channel;
+
+    /* File descriptor of /dev/spidevB.C (SPI), -1 if closed */
+    int spi_fd;
+
+    /* Chip select C of /dev/spidevB.C (SPI) */
+    uint8_t spi_cs;
+
+    /* SPI clock in Hz (SPI) */
+    uint32_t spi_speed_hz;
+
+    /* Emulated sensor (fake), NULL if closed */
+    struct pi3g_fake *fake;
+
+    /* Transfer counters, see pi3g_stats_reset */
+    struct pi3g_stats stats;
+
+    /* Spin margin of the driver's delays in ns, 0 to just sleep, see
+     * pi3g_delay_us */
+    uint32_t spin_ns;
+};
+
+/* Entry of a binary min-heap of deadlines, see pi3g_heap_push() */
+struct pi3g_deadline
+{
+    /* On the pi3g_timestamp_ns() clock */
+    int64_t deadline_ns;
+
+    /* What is due, chosen by the caller */
+    uint32_t id;
+};
+
+#ifdef BSEC
+/* Outcome of one BSEC measurement cycle */
+struct pi3g_bsec_sample
+{
+    /* Time of the bsec_sensor_control call in ns */
+    int64_t time_stamp;
+
+    /* sample_count of the sensor after this sample */
+    uint16_t sample_nr;
+
+    /* 1 if bsec_do_steps produced the outputs below */
+    uint8_t processed;
+
+    /* Outputs of all fields of the cycle, one per sensor_id */
+    uint8_t n_outputs;
+    bsec_output_t outputs[BSEC_NUMBER_OUTPUTS];
+};
+
+/* Bounded lock-free single-producer/single-consumer ring of samples. A
+ * full ring drops the new sample, the consumer never waits. The ring's
+ * eventfd is readable while samples are queued, for select/poll/epoll. */
+struct pi3g_sample_ring
+{
+    struct pi3g_bsec_sample slots[PI3G_SAMPLE_RING_DEPTH];
+
+    /* Next slot to fill, written by the producer only */
+    atomic_size_t tail;
+
+    /* Next slot to drain, written by the consumer only */
+    atomic_size_t head;
+
+    /* Times the producer ran into a full ring, and samples lost to it */
+    atomic_uint_least64_t overruns;
+    atomic_uint_least64_t dropped;
+
+    /* Producer side, 1 while the ring is full */
+    uint8_t full;
+
+    /* Non-blocking eventfd, signalled by every push */
+    int efd;
+};
+
+/* How well the BSEC calls of a sensor keep to the schedule BSEC asks for */
+struct pi3g_bsec_timing
+{
+    /* bsec_sensor_control calls, and the next_call and interval the last
+     * one asked for */
+    uint64_t calls;
+    int64_t next_call_ns;
+    int64_t period_ns;
+
+    /* Lateness of the calls against the previous next_call: last, sum
+     * and maximum in ns, log2 histogram in us */
+    int64_t lateness_ns;
+    int64_t lateness_sum_ns;
+    int64_t lateness_max_ns;
+    uint64_t lateness_hist[PI3G_STATS_N_BUCKETS];
+
+    /* Processed samples, time of the last one and the interval requested
+     * when it was taken */
+    uint64_t samples;
+    int64_t sample_ns;
+    int64_t sample_period_ns;
+
+    /* Measured minus requested interval between samples: sum in ns,
+     * largest deviation in ns, log2 histogram of the deviations in us.
+     * missed counts the intervals out of tolerance. */
+    uint64_t intervals;
+    int64_t interval_err_sum_ns;
+    int64_t interval_err_max_ns;
+    uint64_t interval_hist[PI3G_STATS_N_BUCKETS];
+    uint64_t missed;
+
+    /* Warnings (> 0) and errors (< 0) returned by bsec_sensor_control and
+     * bsec_do_steps, by code in order of first appearance */
+    bsec_library_return_t codes[PI3G_BSEC_N_CODES];
+    uint64_t code_counts[PI3G_BSEC_N_CODES];
+    uint8_t n_codes;
+    uint64_t other_codes;
+};
+#endif
+
 /* CPP guard */
 #ifdef __cplusplus
 extern "C"
@@ -34,12 +392,84 @@ extern "C"
 
     uint16_t get_max(uint16_t array[], int8_t len);
 
+    int8_t pi3g_set_clock(const char *name, int64_t start_ns);
+
+    const char *pi3g_clock_name();
+
+    uint8_t pi3g_clock_is_virtual();
+
+    int64_t pi3g_clock_advance_ns(int64_t duration_ns);
+
+    time_t pi3g_clock_wall_s();
+
     void pi3g_delay_us(uint32_t duration_us, void *intf_ptr);
+    int pi3g_sleep_until_ns(int64_t deadline_ns);
+    int64_t pi3g_spin_until_ns(int64_t deadline_ns);
+    uint32_t pi3g_calibrate_spin_ns();
+
+    void pi3g_wake_stats_add(struct pi3g_wake_stats *stats, int64_t err_ns);
+    void pi3g_wake_stats_start(struct pi3g_wake_stats *stats);
+    void pi3g_wake_stats_update(struct pi3g_wake_stats *stats);
+
+    int pi3g_set_timer_slack_ns(uint64_t slack_ns);
+
+    int pi3g_rt_thread_attr(pthread_attr_t *attr, int priority, int cpu);
+    int pi3g_rt_lock_memory();
+
+    void pi3g_heap_push(struct pi3g_deadline *heap, size_t *n, int64_t deadline_ns, uint32_t id);
+
+    struct pi3g_deadline pi3g_heap_pop(struct pi3g_deadline *heap, size_t *n);
 
     int8_t pi3g_read(uint8_t regAddr, uint8_t *regData, uint32_t len, void *intf_ptr);
 
     int8_t pi3g_write(uint8_t regAddr, const uint8_t *regData, uint32_t len, void *intf_ptr);
 
+    int8_t pi3g_readv(const struct bme69x_read_seg *segs, uint8_t n_segs, void *intf_ptr);
+
+    uint8_t pi3g_set_i2c_mode(struct pi3g_intf *intf, uint8_t mode);
+
+    const struct pi3g_transport *pi3g_get_transport(const char *name);
+
+    int8_t pi3g_intf_open(struct pi3g_intf *intf);
+
+    void pi3g_intf_close(struct pi3g_intf *intf);
+
+    uint8_t pi3g_intf_is_open(const struct pi3g_intf *intf);
+
+    int pi3g_intf_fd(const struct pi3g_intf *intf);
+
+    int8_t pi3g_spi_read(uint8_t regAddr, uint8_t *regData, uint32_t len, void *intf_ptr);
+
+    int8_t pi3g_spi_write(uint8_t regAddr, const uint8_t *regData, uint32_t len, void *intf_ptr);
+
+    struct pi3g_bus *pi3g_bus_open(uint8_t bus_nr);
+
+    int8_t pi3g_bus_reopen(struct pi3g_bus *bus);
+
+    void pi3g_bus_close(struct pi3g_bus *bus);
+
+    void pi3g_bus_lock(struct pi3g_bus *bus);
+
+    void pi3g_bus_unlock(struct pi3g_bus *bus);
+
+    int8_t pi3g_bus_enable_flock(struct pi3g_bus *bus);
+
+    void pi3g_bus_get_lock_stats(struct pi3g_bus *bus, struct pi3g_lock_stats *stats);
+
+    uint64_t pi3g_bus_get_mux_switches(struct pi3g_bus *bus);
+
+    void pi3g_bus_reset_stats(struct pi3g_bus *bus);
+
+    void pi3g_intf_lock(struct pi3g_intf *intf);
+
+    void pi3g_intf_unlock(struct pi3g_intf *intf);
+
+    void pi3g_stats_reset(struct pi3g_stats *stats);
+
+    void pi3g_mux_order(struct pi3g_intf *intfs[], uint8_t n_intfs, uint8_t *order);
+
+    int8_t pi3g_bus_read_fields(struct pi3g_intf *intfs[], uint8_t n_intfs, uint8_t (*buffs)[BME69X_LEN_FIELD], int8_t *rslts);
+
     int8_t pi3g_set_conf(uint8_t os_hum, uint8_t os_pres, uint8_t os_temp, uint8_t filter, uint8_t odr, struct bme69x_conf *conf, struct bme69x_dev *bme, uint8_t debug_mode);
 
     int8_t pi3g_set_heater_conf_fm(uint8_t enable, uint16_t heatr_temp, uint16_t heatr_dur, struct bme69x_heatr_conf *heatr_conf, struct bme69x_dev *bme, uint8_t debug_mode);
@@ -68,6 +498,24 @@ extern "C"
     float get_sample_rate_from_bsec();
 
     void tvoc_equivalent_calibration();
+
+    int8_t pi3g_sample_ring_init(struct pi3g_sample_ring *ring);
+
+    void pi3g_sample_ring_close(struct pi3g_sample_ring *ring);
+
+    int8_t pi3g_sample_ring_push(struct pi3g_sample_ring *ring, const struct pi3g_bsec_sample *sample);
+
+    size_t pi3g_sample_ring_pop(struct pi3g_sample_ring *ring, struct pi3g_bsec_sample *samples, size_t max_n);
+
+    size_t pi3g_sample_ring_count(struct pi3g_sample_ring *ring);
+
+    void pi3g_bsec_timing_reset(struct pi3g_bsec_timing *timing);
+
+    void pi3g_bsec_timing_call(struct pi3g_bsec_timing *timing, int64_t time_stamp, int64_t next_call);
+
+    void pi3g_bsec_timing_sample(struct pi3g_bsec_timing *timing, int64_t time_stamp);
+
+    void pi3g_bsec_timing_result(struct pi3g_bsec_timing *timing, bsec_library_return_t rslt);
 #endif
 
 #ifdef __cplusplus